@@ -17,8 +17,66 @@ concept AlphaBeta =
 } &&
 totally_ordered<typename State::Cost>;
 
-template<AlphaBeta State>
-typename State::Cost get_best_score(State &state, typename State::Cost alpha, typename State::Cost beta, const size_t depth) {
+template<class State>
+struct AlphaBetaPush {
+  void operator()(const typename State::Action &) const {
+  }
+};
+
+template<class State>
+concept InlineAlphaBeta =
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             AlphaBetaPush<State> &push)
+{
+  typename State::Action;
+  typename State::Cost;
+
+  { cs.expand(push) } -> same_as<void>;
+  { cs.is_finished() } -> same_as<bool>;
+  { cs.evaluate() } -> same_as<typename State::Cost>;
+  { s.apply(a) } -> same_as<void>;
+  { s.rollback(a) } -> same_as<void>;
+} &&
+totally_ordered<typename State::Cost>;
+
+// opt-in for the transposition table
+template<class State>
+concept HashedAlphaBeta =
+    (AlphaBeta<State> or InlineAlphaBeta<State>) &&
+    requires(const State &cs)
+{
+  { cs.hash() } -> convertible_to<uint64_t>;
+};
+
+// the largest cost below x
+template<typename Cost>
+Cost predecessor(const Cost x) {
+  if constexpr (integral<Cost>) {
+    return x - 1;
+  } else {
+    return nextafter(x, -numeric_limits<Cost>::infinity());
+  }
+}
+
+// the smallest cost above x
+template<typename Cost>
+Cost successor(const Cost x) {
+  if constexpr (integral<Cost>) {
+    return x + 1;
+  } else {
+    return nextafter(x, numeric_limits<Cost>::infinity());
+  }
+}
+
+// The candidates of all plies share stack, see MoveStack.
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Cost get_best_score(State &state,
+                                    typename State::Cost alpha,
+                                    typename State::Cost beta,
+                                    const size_t depth,
+                                    MoveStack<typename State::Action> &stack) {
   using Action = typename State::Action;
   using Cost = typename State::Cost;
 
@@ -26,47 +84,236 @@ typename State::Cost get_best_score(State &state, typename State::Cost alpha, ty
     return state.evaluate();
   }
 
-  vector<Action> candidates;
-  state.expand([&](const Action &a) { candidates.emplace_back(a); });
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
 
-  if (candidates.empty()) {
+  if (n == 0) {
     return state.evaluate();
   }
 
-  for (const auto &action : candidates) {
+  for (size_t i = 0; i < n; i++) {
+    // a copy, the frame moves if a child grows the stack
+    const Action action = stack.frame(first)[i];
     state.apply(action);
-    Cost score = -get_best_score(state, -beta, -alpha, depth - 1);
+    Cost score = -get_best_score(state, -beta, -alpha, depth - 1, stack);
     if (score > alpha) {
       alpha = score;
     }
     state.rollback(action);
     if (alpha >= beta) {
-      return alpha;
+      break;
     }
   }
+  stack.pop(first);
   return alpha;
 }
 
-template<AlphaBeta State>
-typename State::Action get_best_action(State &state, const size_t depth) {
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Cost get_best_score(State &state, typename State::Cost alpha, typename State::Cost beta, const size_t depth) {
+  MoveStack<typename State::Action> stack;
+  return get_best_score(state, alpha, beta, depth, stack);
+}
+
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Action get_best_action(State &state, const size_t depth, MoveStack<typename State::Action> &stack) {
   using Action = typename State::Action;
   using Cost = typename State::Cost;
   assert(depth > 0 and not state.is_finished());
-  vector<Action> candidates;
-  state.expand([&](const Action &a) { candidates.emplace_back(a); });
-  assert(not candidates.empty());
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
+  assert(n > 0);
   Cost alpha = -numeric_limits<Cost>::max();
   Cost beta = numeric_limits<Cost>::max();
-  Action best_action;
-  for (const auto &action : candidates) {
+  Action best_action = stack.frame(first)[0];
+  for (size_t i = 0; i < n; i++) {
+    const Action action = stack.frame(first)[i];
     state.apply(action);
-    Cost score = -get_best_score(state, -beta, -alpha, depth - 1);
+    Cost score = -get_best_score(state, -beta, -alpha, depth - 1, stack);
     if (score > alpha) {
       alpha = score;
       best_action = action;
     }
     state.rollback(action);
   }
+  stack.pop(first);
   return best_action;
 }
+
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Action get_best_action(State &state, const size_t depth) {
+  MoveStack<typename State::Action> stack;
+  return get_best_action(state, depth, stack);
+}
+
+// NegaScout: the first child is searched with the full window, the others with the null window
+// (alpha, successor(alpha)) and again with (alpha, beta) only if they fail high. The score is the
+// one of get_best_score; it pays off when expand pushes good actions first.
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Cost principal_variation_search(State &state,
+                                                typename State::Cost alpha,
+                                                typename State::Cost beta,
+                                                const size_t depth,
+                                                MoveStack<typename State::Action> &stack) {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+
+  if (depth == 0 or state.is_finished()) {
+    return state.evaluate();
+  }
+
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
+
+  if (n == 0) {
+    return state.evaluate();
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    const Action action = stack.frame(first)[i];
+    state.apply(action);
+    Cost score;
+    if (i == 0) {
+      score = -principal_variation_search(state, -beta, -alpha, depth - 1, stack);
+    } else {
+      score = -principal_variation_search(state, -successor(alpha), -alpha, depth - 1, stack);
+      if (score > alpha and score < beta) {
+        score = -principal_variation_search(state, -beta, -alpha, depth - 1, stack);
+      }
+    }
+    if (score > alpha) {
+      alpha = score;
+    }
+    state.rollback(action);
+    if (alpha >= beta) {
+      break;
+    }
+  }
+  stack.pop(first);
+  return alpha;
+}
+
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+typename State::Cost principal_variation_search(State &state,
+                                                typename State::Cost alpha,
+                                                typename State::Cost beta,
+                                                const size_t depth) {
+  MoveStack<typename State::Action> stack;
+  return principal_variation_search(state, alpha, beta, depth, stack);
+}
+
+// Searches the action stored for the state first, and returns the stored score without a search
+// if it was searched at least as deep and its bound decides the window.
+template<typename State, typename Table> requires HashedAlphaBeta<State>
+typename State::Cost get_best_score(State &state,
+                                    typename State::Cost alpha,
+                                    typename State::Cost beta,
+                                    const size_t depth,
+                                    Table &table,
+                                    MoveStack<typename State::Action> &stack) {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+
+  if (depth == 0 or state.is_finished()) {
+    return state.evaluate();
+  }
+
+  const uint64_t key = state.hash();
+  size_t stored = 0;
+  if (const auto entry = table.probe(key)) {
+    if (entry->depth >= depth) {
+      if (entry->bound == Table::EXACT or
+          (entry->bound == Table::LOWER and entry->score >= beta) or
+          (entry->bound == Table::UPPER and entry->score <= alpha)) {
+        return entry->score;
+      }
+    }
+    if (entry->move != Table::NO_MOVE) {
+      stored = entry->move;
+    }
+  }
+
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
+
+  if (n == 0) {
+    return state.evaluate();
+  }
+  if (stored >= n) {
+    stored = 0;
+  }
+
+  uint16_t best = Table::NO_MOVE;
+  for (size_t k = 0; k < n; k++) {
+    // the stored action and then the others in order
+    const size_t i = k == 0 ? stored : k <= stored ? k - 1 : k;
+    const Action action = stack.frame(first)[i];
+    state.apply(action);
+    Cost score = -get_best_score(state, -beta, -alpha, depth - 1, table, stack);
+    if (score > alpha) {
+      alpha = score;
+      best = static_cast<uint16_t>(i);
+    }
+    state.rollback(action);
+    if (alpha >= beta) {
+      break;
+    }
+  }
+  stack.pop(first);
+  table.store(key, alpha, depth, alpha >= beta ? Table::LOWER : best == Table::NO_MOVE ? Table::UPPER : Table::EXACT, best);
+  return alpha;
+}
+
+template<typename State, typename Table> requires HashedAlphaBeta<State>
+typename State::Cost get_best_score(State &state,
+                                    typename State::Cost alpha,
+                                    typename State::Cost beta,
+                                    const size_t depth,
+                                    Table &table) {
+  MoveStack<typename State::Action> stack;
+  return get_best_score(state, alpha, beta, depth, table, stack);
+}
+
+template<typename State, typename Table> requires HashedAlphaBeta<State>
+typename State::Action get_best_action(State &state,
+                                       const size_t depth,
+                                       Table &table) {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+  assert(depth > 0 and not state.is_finished());
+  table.new_search();
+  MoveStack<Action> stack;
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size();
+  assert(n > 0);
+  const uint64_t key = state.hash();
+  size_t stored = 0;
+  if (const auto entry = table.probe(key); entry and entry->move < n) {
+    stored = entry->move;
+  }
+  Cost alpha = -numeric_limits<Cost>::max();
+  Cost beta = numeric_limits<Cost>::max();
+  size_t best = stored;
+  for (size_t k = 0; k < n; k++) {
+    const size_t i = k == 0 ? stored : k <= stored ? k - 1 : k;
+    const Action action = stack.frame(0)[i];
+    state.apply(action);
+    Cost score = -get_best_score(state, -beta, -alpha, depth - 1, table, stack);
+    if (score > alpha) {
+      alpha = score;
+      best = i;
+    }
+    state.rollback(action);
+  }
+  table.store(key, alpha, depth, Table::EXACT, static_cast<uint16_t>(best));
+  return stack.frame(0)[best];
+}
 }
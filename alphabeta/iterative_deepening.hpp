@@ -0,0 +1,324 @@
+namespace AlphaBeta {
+// opt-in for the history heuristic: a small non-negative id per action, equal for the same move
+// in different positions
+template<class State>
+concept IdentifiedAction =
+    requires(const State &cs, const typename State::Action &a)
+{
+  { cs.action_id(a) } -> convertible_to<size_t>;
+};
+
+struct NoTranspositionTable {
+};
+
+template<typename State>
+struct IterativeDeepeningResult {
+  typename State::Action action;
+  typename State::Cost score;
+  size_t depth; // the last completed depth
+  size_t nodes;
+};
+
+// Principal variation search of depth 1, 2, ... until the time is up. Each iteration searches
+// the principal variation of the previous one first, then the move of the transposition table,
+// the killer moves of the ply and the rest by the history heuristic. With aspiration > 0 an
+// iteration starts with the window previous score -/+ aspiration and doubles the side it fails
+// on until the score falls inside. Timer is checked every
+// CHECK_INTERVAL nodes; an iteration that runs out of time unwinds and is discarded.
+// Among root actions of the same score the first in expand order is returned, whatever the
+// order of the search, so the result at a fixed depth does not depend on the history of the
+// table or the killers.
+template<typename State, typename Table = NoTranspositionTable>
+struct IterativeDeepening {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+
+  static constexpr bool HASHED = not same_as<Table, NoTranspositionTable>;
+  static constexpr uint16_t NO_MOVE = numeric_limits<uint16_t>::max();
+  static constexpr size_t CHECK_INTERVAL = 1024;
+
+  // stop aborts the search when set by another thread; rotation shifts the root actions after
+  // the first, so that helpers of a parallel search start in different subtrees
+  IterativeDeepening(State &state,
+                     const int64_t end_milliseconds,
+                     const size_t max_depth,
+                     const Cost aspiration = Cost{},
+                     Table *table = nullptr,
+                     const atomic<bool> *stop = nullptr,
+                     const size_t rotation = 0)
+    : state(state), end_milliseconds(end_milliseconds), max_depth(max_depth), aspiration(aspiration), table(table),
+      stop(stop), rotation(rotation), plies(max_depth + 1) {
+  }
+
+  IterativeDeepeningResult<State> run() {
+    assert(max_depth > 0 and not state.is_finished());
+    IterativeDeepeningResult<State> result{};
+    for (size_t depth = 1; depth <= max_depth; depth++) {
+      horizon = false;
+      const Cost score = search_root(depth, result.score);
+      if (aborted) {
+        break;
+      }
+      const auto &root = plies[0];
+      assert(not root.candidates.empty());
+      principal = root.pv;
+      completed = depth;
+      result = {root.candidates[principal.empty() ? 0 : principal[0]], score, depth, nodes};
+      // every line ended before the depth limit, a deeper search finds nothing new
+      if (not horizon) {
+        break;
+      }
+    }
+    result.nodes = nodes;
+    return result;
+  }
+
+  private:
+    struct Ply {
+      vector<Action> candidates; // in expand order
+      vector<int64_t> priorities;
+      vector<uint16_t> order; // indices of candidates, best first
+      vector<uint16_t> pv; // indices of the best line from this ply
+      array<optional<Action>, 2> killers;
+    };
+
+    State &state;
+    const Timer timer;
+    const int64_t end_milliseconds;
+    const size_t max_depth;
+    const Cost aspiration;
+    Table *table;
+    const atomic<bool> *stop;
+    const size_t rotation;
+    vector<Ply> plies;
+    vector<uint16_t> principal;
+    vector<int64_t> history;
+    size_t nodes = 0;
+    size_t completed = 0;
+    bool aborted = false, horizon = false;
+
+    Cost search_root(const size_t depth, const Cost previous) {
+      constexpr Cost INF = numeric_limits<Cost>::max();
+      if (not(aspiration > Cost{}) or completed == 0) {
+        return search(-INF, INF, depth, 0, true);
+      }
+      // the window bounds saturate at -/+INF
+      const auto widen = [](const Cost x, const Cost delta) { return x < INF - delta ? x + delta : INF; };
+      Cost low = aspiration, high = aspiration;
+      while (true) {
+        const Cost alpha = -widen(-previous, low), beta = widen(previous, high);
+        horizon = false;
+        const Cost score = search(alpha, beta, depth, 0, true);
+        if (aborted) {
+          return score;
+        }
+        if (score <= alpha and alpha > -INF) {
+          low = widen(low, low);
+        } else if (score >= beta and beta < INF) {
+          high = widen(high, high);
+        } else {
+          return score;
+        }
+      }
+    }
+
+    Cost search(Cost alpha, Cost beta, const size_t depth, const size_t ply, const bool on_pv) {
+      // the first iteration always completes, so there is a move to return
+      if (++nodes % CHECK_INTERVAL == 0 and ply > 0 and completed > 0 and
+          timer.get_milliseconds() >= end_milliseconds) {
+        aborted = true;
+      }
+      if (stop != nullptr and stop->load(memory_order_relaxed)) {
+        aborted = true;
+      }
+      if (aborted) {
+        return alpha;
+      }
+      auto &p = plies[ply];
+      p.pv.clear();
+      if (state.is_finished()) {
+        return state.evaluate();
+      }
+      if (depth == 0) {
+        horizon = true;
+        return state.evaluate();
+      }
+
+      uint64_t key = 0;
+      uint16_t hash_move = NO_MOVE;
+      if constexpr (HASHED) {
+        key = state.hash();
+        if (const auto entry = table->probe(key)) {
+          if (ply > 0 and entry->depth >= depth and
+              (entry->bound == Table::EXACT or
+               (entry->bound == Table::LOWER and entry->score >= beta) or
+               (entry->bound == Table::UPPER and entry->score <= alpha))) {
+            horizon = true;
+            return entry->score;
+          }
+          hash_move = entry->move;
+        }
+      }
+
+      p.candidates.clear();
+      const auto push = [&](const Action &a) { p.candidates.emplace_back(a); };
+      state.expand(push);
+      if (p.candidates.empty()) {
+        return state.evaluate();
+      }
+      const uint16_t pv_move = on_pv and ply < principal.size() ? principal[ply] : NO_MOVE;
+      sort_candidates(p, pv_move, hash_move);
+      if (ply == 0 and rotation > 0 and p.order.size() > 2) {
+        ranges::rotate(p.order.begin() + 1, p.order.begin() + 1 + rotation % (p.order.size() - 1), p.order.end());
+      }
+
+      uint16_t best = NO_MOVE;
+      for (size_t k = 0; k < p.order.size(); k++) {
+        const uint16_t i = p.order[k];
+        const Action &action = p.candidates[i];
+        // at the root an action before the best one in expand order also wins with an equal score
+        const bool tie = ply == 0 and best != NO_MOVE and i < best;
+        const Cost lower = tie ? predecessor(alpha) : alpha;
+        state.apply(action);
+        Cost score;
+        if (k == 0) {
+          score = -search(-beta, -lower, depth - 1, ply + 1, i == pv_move);
+        } else {
+          // a null window proves the child is not better, unless it fails high
+          score = -search(-successor(lower), -lower, depth - 1, ply + 1, false);
+          if (score > lower and score < beta and not aborted) {
+            score = -search(-beta, -lower, depth - 1, ply + 1, false);
+          }
+        }
+        state.rollback(action);
+        if (aborted) {
+          return alpha;
+        }
+        if (score > alpha or (tie and score == alpha)) {
+          alpha = score;
+          best = i;
+          const auto &child = plies[ply + 1].pv;
+          p.pv.assign(1, i);
+          p.pv.insert(p.pv.end(), child.begin(), child.end());
+        }
+        if (alpha >= beta) {
+          update_cutoff(p, action, depth);
+          if constexpr (HASHED) {
+            table->store(key, alpha, depth, Table::LOWER, best);
+          }
+          return alpha;
+        }
+      }
+      if constexpr (HASHED) {
+        table->store(key, alpha, depth, best == NO_MOVE ? Table::UPPER : Table::EXACT, best);
+      }
+      return alpha;
+    }
+
+    void sort_candidates(Ply &p, const uint16_t pv_move, const uint16_t hash_move) {
+      constexpr int64_t FIRST = numeric_limits<int64_t>::max();
+      const size_t n = p.candidates.size();
+      assert(n < NO_MOVE);
+      p.priorities.resize(n);
+      p.order.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        const Action &action = p.candidates[i];
+        int64_t priority = 0;
+        if constexpr (IdentifiedAction<State>) {
+          if (const size_t id = state.action_id(action); id < history.size()) {
+            priority = history[id];
+          }
+        }
+        if constexpr (equality_comparable<Action>) {
+          if (p.killers[0] == action) {
+            priority = FIRST - 2;
+          } else if (p.killers[1] == action) {
+            priority = FIRST - 3;
+          }
+        }
+        if (i == hash_move) {
+          priority = FIRST - 1;
+        }
+        if (i == pv_move) {
+          priority = FIRST;
+        }
+        p.priorities[i] = priority;
+        p.order[i] = static_cast<uint16_t>(i);
+      }
+      // insertion sort: stable and without allocation for the few candidates of a node
+      for (size_t i = 1; i < n; i++) {
+        const uint16_t x = p.order[i];
+        size_t j = i;
+        for (; j > 0 and p.priorities[p.order[j - 1]] < p.priorities[x]; j--) {
+          p.order[j] = p.order[j - 1];
+        }
+        p.order[j] = x;
+      }
+    }
+
+    void update_cutoff(Ply &p, const Action &action, const size_t depth) {
+      if constexpr (equality_comparable<Action>) {
+        if (p.killers[0] != action) {
+          p.killers[1] = p.killers[0];
+          p.killers[0] = action;
+        }
+      }
+      if constexpr (IdentifiedAction<State>) {
+        const size_t id = state.action_id(action);
+        if (id >= history.size()) {
+          history.resize(id + 1);
+        }
+        history[id] += static_cast<int64_t>(depth * depth);
+      }
+    }
+};
+
+template<typename State> requires AlphaBeta<State> or InlineAlphaBeta<State>
+IterativeDeepeningResult<State> iterative_deepening(State &state,
+                                                    const int64_t end_milliseconds,
+                                                    const size_t max_depth = 64,
+                                                    const typename State::Cost aspiration = {}) {
+  return IterativeDeepening<State>(state, end_milliseconds, max_depth, aspiration).run();
+}
+
+template<typename State, typename Table> requires HashedAlphaBeta<State>
+IterativeDeepeningResult<State> iterative_deepening(State &state,
+                                                    const int64_t end_milliseconds,
+                                                    const size_t max_depth,
+                                                    Table &table,
+                                                    const typename State::Cost aspiration = {}) {
+  table.new_search();
+  return IterativeDeepening<State, Table>(state, end_milliseconds, max_depth, aspiration, &table).run();
+}
+
+// Lazy SMP: num_threads - 1 helpers run iterative_deepening on copies of the state and fill the
+// shared table, and stop when the calling thread is done. The result is the one of the calling
+// thread, so at a fixed depth it is the result of the serial search; the helpers only change
+// how fast it is found.
+template<typename State, typename Table> requires HashedAlphaBeta<State> and copyable<State>
+IterativeDeepeningResult<State> lazy_smp(State &state,
+                                         const int64_t end_milliseconds,
+                                         const size_t max_depth,
+                                         const size_t num_threads,
+                                         Table &table,
+                                         const typename State::Cost aspiration = {}) {
+  table.new_search();
+  atomic<bool> stop = false;
+  vector<State> copies(num_threads > 1 ? num_threads - 1 : 0, state);
+  vector<size_t> nodes(copies.size());
+  vector<thread> threads;
+  for (size_t t = 0; t < copies.size(); t++) {
+    threads.emplace_back([&, t] {
+      nodes[t] = IterativeDeepening<State, Table>(copies[t], end_milliseconds, max_depth, aspiration, &table, &stop, t + 1)
+          .run().nodes;
+    });
+  }
+  auto result = IterativeDeepening<State, Table>(state, end_milliseconds, max_depth, aspiration, &table).run();
+  stop = true;
+  for (auto &th : threads) {
+    th.join();
+  }
+  result.nodes += reduce(nodes.begin(), nodes.end(), size_t{0});
+  return result;
+}
+}
@@ -0,0 +1,153 @@
+namespace AlphaBeta {
+enum class Replacement {
+  DEPTH, // keep deep entries, also from recent earlier searches
+  AGE, // keep the entries of the current search
+};
+
+// Fixed size table of search results keyed by the 64-bit hash of a state. Entries are grouped
+// in buckets of one cache line, so a probe touches one line. move is the index of the best
+// action in the order expand pushed it.
+// The table may be shared by threads without locks: an entry is a few relaxed atomic words, the
+// first holding the key xor the others, so an entry torn by a concurrent store fails the key
+// check and reads as a miss.
+template<class Cost, Replacement Policy = Replacement::DEPTH>
+  requires is_trivially_copyable_v<Cost>
+struct TranspositionTable {
+  enum Bound : uint8_t {
+    NONE, UPPER, LOWER, EXACT
+  };
+
+  static constexpr uint16_t NO_MOVE = numeric_limits<uint16_t>::max();
+
+  struct Entry {
+    Cost score;
+    uint16_t move;
+    uint8_t depth;
+    uint8_t bound : 2, generation : 6;
+  };
+
+  static constexpr size_t WORDS = (sizeof(Entry) + 7) / 8;
+
+  struct Slot {
+    array<atomic<uint64_t>, WORDS + 1> words{};
+  };
+
+  static constexpr size_t BUCKET_SIZE = max<size_t>(64 / sizeof(Slot), 1);
+
+  struct alignas(64) Bucket {
+    array<Slot, BUCKET_SIZE> slots{};
+  };
+
+  // n is the number of entries, rounded up to a power of two of buckets
+  explicit TranspositionTable(const size_t n)
+    : generation(0), buckets(bit_ceil(max<size_t>((n + BUCKET_SIZE - 1) / BUCKET_SIZE, 1))) {
+    shift = 64 - countr_zero(buckets.size());
+  }
+
+  [[nodiscard]] optional<Entry> probe(const uint64_t key) const {
+    for (const auto &slot : bucket(key).slots) {
+      uint64_t check;
+      const Entry entry = load(slot, check);
+      if (entry.bound != NONE and check == key) {
+        return entry;
+      }
+    }
+    return nullopt;
+  }
+
+  void store(const uint64_t key, const Cost score, const size_t depth, const Bound bound, const uint16_t move) {
+    assert(depth <= numeric_limits<uint8_t>::max());
+    auto &slots = bucket(key).slots;
+    Slot *victim = nullptr;
+    Entry old{};
+    bool same = false;
+    for (auto &slot : slots) {
+      uint64_t check;
+      const Entry entry = load(slot, check);
+      if (entry.bound == NONE or check == key) {
+        victim = &slot;
+        old = entry;
+        same = entry.bound != NONE;
+        break;
+      }
+      if (victim == nullptr or worth(entry) < worth(old)) {
+        victim = &slot;
+        old = entry;
+      }
+    }
+    if constexpr (Policy == Replacement::DEPTH) {
+      // a shallower result of the same search only replaces a deeper one if it is exact
+      if (same and old.generation == generation and depth < old.depth and bound != EXACT) {
+        return;
+      }
+    }
+    const uint16_t kept = move == NO_MOVE and same ? old.move : move;
+    save(*victim, key, {score, kept, static_cast<uint8_t>(depth), bound, generation});
+  }
+
+  // entries of earlier searches become the first to be replaced; not concurrently with a search
+  void new_search() {
+    generation = (generation + 1) & 63;
+  }
+
+  void clear() {
+    for (auto &b : buckets) {
+      for (auto &slot : b.slots) {
+        for (auto &word : slot.words) {
+          word.store(0, memory_order_relaxed);
+        }
+      }
+    }
+    generation = 0;
+  }
+
+  private:
+    uint8_t generation;
+    int shift;
+    vector<Bucket> buckets;
+
+    [[nodiscard]] const Bucket &bucket(const uint64_t key) const {
+      return buckets[shift == 64 ? 0 : key * 0x9e3779b97f4a7c15ull >> shift];
+    }
+
+    [[nodiscard]] Bucket &bucket(const uint64_t key) {
+      return buckets[shift == 64 ? 0 : key * 0x9e3779b97f4a7c15ull >> shift];
+    }
+
+    // check is the key the entry was stored with, if no store tore it
+    [[nodiscard]] static Entry load(const Slot &slot, uint64_t &check) {
+      array<uint64_t, WORDS> data;
+      check = slot.words[0].load(memory_order_relaxed);
+      for (size_t i = 0; i < WORDS; i++) {
+        data[i] = slot.words[i + 1].load(memory_order_relaxed);
+        check ^= data[i];
+      }
+      Entry entry;
+      memcpy(&entry, data.data(), sizeof(Entry));
+      return entry;
+    }
+
+    static void save(Slot &slot, const uint64_t key, const Entry &entry) {
+      array<uint64_t, WORDS> data{};
+      memcpy(data.data(), &entry, sizeof(Entry));
+      uint64_t check = key;
+      for (size_t i = 0; i < WORDS; i++) {
+        slot.words[i + 1].store(data[i], memory_order_relaxed);
+        check ^= data[i];
+      }
+      slot.words[0].store(check, memory_order_relaxed);
+    }
+
+    // the entry with the lowest worth is replaced
+    [[nodiscard]] int worth(const Entry &entry) const {
+      const int age = (generation - entry.generation) & 63;
+      if constexpr (Policy == Replacement::DEPTH) {
+        // a deep entry outlives a few searches
+        return entry.depth - 8 * age;
+      } else {
+        // any entry of an earlier search goes before one of the current search
+        return entry.depth - 256 * age;
+      }
+    }
+};
+}
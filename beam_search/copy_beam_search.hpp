@@ -0,0 +1,209 @@
+namespace BeamSearch {
+template<class State>
+concept CopyBeamState =
+    Evaluator<typename State::Evaluator> &&
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             typename State::Evaluator &e,
+             typename State::Hash &h,
+             function<void(const typename State::Action &,
+                           const typename State::Evaluator &,
+                           const typename State::Hash &,
+                           bool)> push)
+    {
+      typename State::Action;
+      typename State::Evaluator;
+      typename State::Hash;
+
+      {
+        cs.make_initial_node()
+      } -> same_as<tuple<typename State::Action, typename State::Evaluator, typename State::Hash> >;
+      { cs.expand(a, e, h, push) } -> same_as<void>;
+      { s.apply(a) } -> same_as<void>;
+    } &&
+    copyable<State> &&
+    HashKey<typename State::Hash>;
+
+template<class State>
+concept InlineCopyBeamState =
+    Evaluator<typename State::Evaluator> &&
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             typename State::Evaluator &e,
+             typename State::Hash &h,
+             BeamPush<State> &push)
+    {
+      typename State::Action;
+      typename State::Evaluator;
+      typename State::Hash;
+
+      {
+        cs.make_initial_node()
+      } -> same_as<tuple<typename State::Action, typename State::Evaluator, typename State::Hash> >;
+      { cs.expand(a, e, h, push) } -> same_as<void>;
+      { s.apply(a) } -> same_as<void>;
+    } &&
+    copyable<State> &&
+    HashKey<typename State::Hash>;
+
+// Every node of the beam owns a copy of its state. A turn expands the nodes in place, and a
+// survivor is built by copying its parent and applying one action, so there is no tour to
+// replay and rollback is never called. history keeps (parent, action) of every node of every
+// turn to restore the path. The interface is the one of EulerTourTree, so run_beam_search
+// drives both.
+template<typename StateType>
+struct CopyBeam {
+  using Action = typename StateType::Action;
+  using Evaluator = typename StateType::Evaluator;
+  using Hash = typename StateType::Hash;
+
+  struct Step {
+    int parent;
+    Action action;
+  };
+
+  explicit CopyBeam(const StateType &state, const int beam_width) {
+    const auto &[action, eval, hash] = state.make_initial_node();
+    states.reserve(beam_width);
+    next_states.reserve(beam_width);
+    states.emplace_back(state);
+    evals.emplace_back(eval);
+    hashes.emplace_back(hash);
+    history.push_back({{-1, action}});
+  }
+
+  template<typename Selector>
+  void dfs(Selector &selector) {
+    expand(selector, 0, static_cast<int>(states.size()));
+  }
+
+  template<typename Selector>
+  void expand(Selector &selector, const int first, const int last) const {
+    const auto &steps = history.back();
+    for (int i = first; i < last; i++) {
+      const SelectorPush<Selector> push{selector, i};
+      states[i].expand(steps[i].action, evals[i], hashes[i], push);
+    }
+  }
+
+  template<typename Selector>
+  void parallel_dfs(Selector &selector, vector<Selector> &workers) {
+    const int n = static_cast<int>(states.size()), parts = static_cast<int>(workers.size());
+    num_threads = workers.size();
+    // update builds the next states on the same threads
+    if (not worker_pool or worker_pool->size() != num_threads) {
+      worker_pool.reset();
+      worker_pool = make_unique<WorkerPool>(num_threads);
+    }
+    if (n < parts) {
+      dfs(selector);
+      return;
+    }
+    for (auto &worker : workers) {
+      worker.bound = selector.bound;
+    }
+    worker_pool->run([&](const size_t t) {
+      expand(workers[t], n * static_cast<int>(t) / parts, n * (static_cast<int>(t) + 1) / parts);
+    });
+    for (int t = 0; t < parts; t++) {
+      selector.merge(workers[t]);
+      workers[t].clear();
+    }
+  }
+
+  template<typename Selector>
+  void update(const Selector &selector) {
+    const int n = static_cast<int>(selector.size());
+    auto &steps = history.emplace_back();
+    steps.reserve(n);
+    next_evals.clear();
+    next_hashes.clear();
+    for (int j = 0; j < n; j++) {
+      const int slot = selector.slots[j];
+      steps.push_back({selector.parents[slot], selector.actions[slot]});
+      next_evals.emplace_back(selector.evals[slot]);
+      next_hashes.emplace_back(selector.hashes[j]);
+    }
+
+    // assign into the nodes of the turn before last, so that their buffers are reused
+    if (static_cast<int>(next_states.size()) > n) {
+      next_states.erase(next_states.begin() + n, next_states.end());
+    }
+    while (static_cast<int>(next_states.size()) < n) {
+      next_states.emplace_back(states[steps[next_states.size()].parent]);
+    }
+    const auto build = [&](const int first, const int last) {
+      for (int j = first; j < last; j++) {
+        next_states[j] = states[steps[j].parent];
+        next_states[j].apply(steps[j].action);
+      }
+    };
+    const int parts = static_cast<int>(num_threads);
+    if (parts <= 1 or n < parts) {
+      build(0, n);
+    } else {
+      worker_pool->run([&](const size_t t) {
+        build(n * static_cast<int>(t) / parts, n * (static_cast<int>(t) + 1) / parts);
+      });
+    }
+
+    states.swap(next_states);
+    evals.swap(next_evals);
+    hashes.swap(next_hashes);
+    num_leaves = n;
+  }
+
+  [[nodiscard]] vector<Action> restore(int parent, int turn) const {
+    vector<Action> ret;
+    ret.reserve(turn);
+    for (size_t t = history.size() - 1; t > 0; t--) {
+      ret.push_back(history[t][parent].action);
+      parent = history[t][parent].parent;
+    }
+    ranges::reverse(ret);
+    return ret;
+  }
+
+  [[nodiscard]] size_t tour_length() const {
+    return 0;
+  }
+
+  size_t num_leaves = 0;
+
+  private:
+    size_t num_threads = 1;
+    unique_ptr<WorkerPool> worker_pool;
+    vector<StateType> states, next_states;
+    vector<Evaluator> evals, next_evals;
+    vector<Hash> hashes, next_hashes;
+    vector<vector<Step> > history;
+};
+
+template<typename State,
+  template<typename> class Selection = SegmentTreeSelection,
+  typename Statistics = NoStatistics,
+  template<typename, typename> class Map = HashMap>
+  requires CopyBeamState<State> or InlineCopyBeamState<State>
+vector<typename State::Action> copy_beam_search(const State &state,
+                                                const size_t max_turn,
+                                                size_t beam_width,
+                                                size_t hash_map_capacity = 0,
+                                                const size_t num_threads = 1,
+                                                Statistics *statistics = nullptr) {
+  if (hash_map_capacity == 0) {
+    hash_map_capacity = 16 * 3 * beam_width;
+  }
+
+  CopyBeam<State> beam(state, beam_width);
+  BeamSelector<State, Selection, Statistics, Map> selector(beam_width, hash_map_capacity);
+  vector<BeamSelector<State, Selection, Statistics, Map> > workers;
+  if (num_threads > 1) {
+    workers.assign(num_threads, BeamSelector<State, Selection, Statistics, Map>(beam_width, hash_map_capacity));
+  }
+
+  const auto next_beam_width = [&](size_t, size_t) { return beam_width; };
+  return run_beam_search(beam, selector, workers, max_turn, next_beam_width, statistics).path;
+}
+}
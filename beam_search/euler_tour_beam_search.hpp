@@ -31,27 +31,58 @@ concept BeamState =
       { s.apply(a) } -> same_as<void>;
       { s.rollback(a) } -> same_as<void>;
     } &&
-    integral<typename State::Hash>;
+    HashKey<typename State::Hash>;
 
-template<typename StateType>
-struct BeamSelector {
-  using Action = typename StateType::Action;
-  using Evaluator = typename StateType::Evaluator;
-  using Cost = typename Evaluator::Cost;
-  using Hash = typename StateType::Hash;
+template<class State>
+struct BeamPush {
+  void operator()(const typename State::Action &,
+                  const typename State::Evaluator &,
+                  const typename State::Hash &,
+                  bool) const {
+  }
 
-  struct Candidate {
-    int parent;
-    Action action;
-    Evaluator eval;
-    Hash hash;
-  };
+  // lazy form: build() returns pair<Evaluator, Hash> and is called only if a child whose cost
+  // is at least lower_bound can still enter the beam
+  template<typename Build>
+  void operator()(const typename State::Action &,
+                  const typename State::Evaluator::Cost &,
+                  const Build &,
+                  bool) const {
+  }
+};
 
-  vector<Candidate> finished_candidates, candidates;
-  using T = pair<Cost, int>;
+template<class State>
+concept InlineBeamState =
+    Evaluator<typename State::Evaluator> &&
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             typename State::Evaluator &e,
+             typename State::Hash &h,
+             BeamPush<State> &push)
+    {
+      typename State::Action;
+      typename State::Evaluator;
+      typename State::Hash;
 
-  vector<T> costs;
-  bool full;
+      {
+        cs.make_initial_node()
+      } -> same_as<tuple<typename State::Action, typename State::Evaluator, typename State::Hash> >;
+      { cs.expand(a, e, h, push) } -> same_as<void>;
+      { s.apply(a) } -> same_as<void>;
+      { s.rollback(a) } -> same_as<void>;
+    } &&
+    HashKey<typename State::Hash>;
+
+// Selection policies decide which candidate leaves the beam.
+//   rejects(cost)   : cost can not enter the beam
+//   evict()         : slot to overwrite with a new candidate, or -1 to append
+//   update(costs, j): costs[j] was appended, replaced or decreased
+//   overflows(size) : the selector has to shrink to beam_width now
+//   shrink(costs)   : indices of the beam_width best candidates in increasing order
+template<typename Cost>
+struct SegmentTreeSelection {
+  using T = pair<Cost, int>;
 
   struct monoid {
     using S = T;
@@ -63,191 +94,838 @@ struct BeamSelector {
       return {-numeric_limits<Cost>::max(), -1};
     }
   };
+
   SegmentTree<monoid> seg;
-  HashMap<Hash, int> hash_to_index;
+  vector<T> costs;
   size_t beam_width;
+  bool full;
 
-  explicit BeamSelector(size_t beam_width, size_t hash_map_capacity)
-    : full(false),
-      seg(monoid(), beam_width),
-      hash_to_index(hash_map_capacity),
-      beam_width(beam_width) {
-    candidates.reserve(beam_width);
+  explicit SegmentTreeSelection(const size_t beam_width)
+    : seg(monoid(), beam_width), beam_width(beam_width), full(false) {
     costs.reserve(beam_width);
   }
 
+  static size_t capacity(const size_t beam_width) {
+    return beam_width;
+  }
+
+  void set_beam_width(const size_t width) {
+    if (width != beam_width) {
+      seg = SegmentTree<monoid>(monoid(), width);
+      beam_width = width;
+      costs.reserve(beam_width);
+    }
+  }
+
+  [[nodiscard]] bool rejects(const Cost &cost) const {
+    return full and cost >= seg.all_prod().first;
+  }
+
+  [[nodiscard]] int evict() const {
+    return full ? seg.all_prod().second : -1;
+  }
+
+  void update(const vector<Cost> &c, const int j) {
+    if (full) {
+      seg.set(j, {c[j], j});
+    } else if (c.size() == beam_width) {
+      costs.clear();
+      for (int k = 0; k < static_cast<int>(c.size()); k++) {
+        costs.emplace_back(c[k], k);
+      }
+      seg.build(costs);
+      full = true;
+    }
+  }
+
+  [[nodiscard]] bool overflows(size_t) const {
+    return false;
+  }
+
+  const vector<int> &shrink(const vector<Cost> &) {
+    assert(false);
+    static const vector<int> none;
+    return none;
+  }
+
+  void clear() {
+    full = false;
+  }
+};
+
+template<typename Cost>
+struct HeapSelection {
+  vector<pair<Cost, int> > heap;
+  vector<int> pos;
+  size_t beam_width;
+  bool full;
+
+  explicit HeapSelection(const size_t beam_width) : beam_width(beam_width), full(false) {
+    heap.reserve(beam_width);
+    pos.resize(beam_width);
+  }
+
+  static size_t capacity(const size_t beam_width) {
+    return beam_width;
+  }
+
+  void set_beam_width(const size_t width) {
+    beam_width = width;
+    heap.reserve(beam_width);
+    pos.resize(beam_width);
+  }
+
+  [[nodiscard]] bool rejects(const Cost &cost) const {
+    return full and cost >= heap[0].first;
+  }
+
+  [[nodiscard]] int evict() const {
+    return full ? heap[0].second : -1;
+  }
+
+  void update(const vector<Cost> &c, const int j) {
+    if (full) {
+      // a replaced or improved candidate only gets cheaper, so it can only sink
+      int k = pos[j];
+      const int n = static_cast<int>(heap.size());
+      const pair<Cost, int> x{c[j], j};
+      while (true) {
+        int child = 2 * k + 1;
+        if (child >= n) break;
+        if (child + 1 < n and heap[child].first < heap[child + 1].first) ++child;
+        if (not(x.first < heap[child].first)) break;
+        heap[k] = heap[child];
+        pos[heap[k].second] = k;
+        k = child;
+      }
+      heap[k] = x;
+      pos[j] = k;
+    } else if (c.size() == beam_width) {
+      heap.clear();
+      for (int k = 0; k < static_cast<int>(c.size()); k++) {
+        heap.emplace_back(c[k], k);
+      }
+      ranges::make_heap(heap, [](const auto &a, const auto &b) { return a.first < b.first; });
+      for (int k = 0; k < static_cast<int>(heap.size()); k++) {
+        pos[heap[k].second] = k;
+      }
+      full = true;
+    }
+  }
+
+  [[nodiscard]] bool overflows(size_t) const {
+    return false;
+  }
+
+  const vector<int> &shrink(const vector<Cost> &) {
+    assert(false);
+    static const vector<int> none;
+    return none;
+  }
+
+  void clear() {
+    full = false;
+  }
+};
+
+template<typename Cost>
+struct NthElementSelection {
+  vector<Cost> buffer;
+  vector<int> keep;
+  Cost threshold;
+  size_t beam_width;
+  bool bounded;
+
+  explicit NthElementSelection(const size_t beam_width) : threshold(), beam_width(beam_width), bounded(false) {
+    buffer.reserve(capacity(beam_width));
+    keep.reserve(beam_width);
+  }
+
+  static size_t capacity(const size_t beam_width) {
+    return 2 * beam_width;
+  }
+
+  void set_beam_width(const size_t width) {
+    beam_width = width;
+    buffer.reserve(capacity(beam_width));
+    keep.reserve(beam_width);
+  }
+
+  [[nodiscard]] bool rejects(const Cost &cost) const {
+    return bounded and cost >= threshold;
+  }
+
+  [[nodiscard]] int evict() const {
+    return -1;
+  }
+
+  void update(const vector<Cost> &, int) {
+  }
+
+  [[nodiscard]] bool overflows(const size_t size) const {
+    return size >= capacity(beam_width);
+  }
+
+  const vector<int> &shrink(const vector<Cost> &c) {
+    buffer.assign(c.begin(), c.end());
+    const auto nth = buffer.begin() + static_cast<ptrdiff_t>(beam_width) - 1;
+    ranges::nth_element(buffer, nth);
+    threshold = *nth;
+    bounded = true;
+    size_t ties = count(buffer.begin(), nth + 1, threshold);
+    keep.clear();
+    for (int k = 0; k < static_cast<int>(c.size()); k++) {
+      if (c[k] < threshold or (ties > 0 and not(threshold < c[k]) and ties--)) {
+        keep.emplace_back(k);
+      }
+    }
+    return keep;
+  }
+
+  void clear() {
+    bounded = false;
+  }
+};
+
+struct NoStatistics {
+  static constexpr bool enabled = false;
+  struct Counters {
+  };
+};
+
+struct BeamStatistics {
+  static constexpr bool enabled = true;
+
+  struct Counters {
+    size_t pushed = 0, rejected = 0, dedup_hits = 0, probes = 0, max_probe = 0, evictions = 0;
+
+    Counters &operator+=(const Counters &other) {
+      pushed += other.pushed;
+      rejected += other.rejected;
+      dedup_hits += other.dedup_hits;
+      probes += other.probes;
+      max_probe = max(max_probe, other.max_probe);
+      evictions += other.evictions;
+      return *this;
+    }
+  };
+
+  struct Turn : Counters {
+    size_t beam_width = 0, tour_length = 0;
+    int64_t dfs_microseconds = 0, update_microseconds = 0;
+  };
+
+  Timer timer;
+  vector<Turn> turns;
+
+  void to_csv(ostream &os) const {
+    os << "turn,beam_width,pushed,rejected,dedup_hits,probes,max_probe,evictions,tour_length,"
+        "dfs_microseconds,update_microseconds\n";
+    for (size_t i = 0; i < turns.size(); i++) {
+      const auto &t = turns[i];
+      os << i << ',' << t.beam_width << ',' << t.pushed << ',' << t.rejected << ',' << t.dedup_hits << ','
+          << t.probes << ',' << t.max_probe << ',' << t.evictions << ',' << t.tour_length << ','
+          << t.dfs_microseconds << ',' << t.update_microseconds << '\n';
+    }
+  }
+
+  void to_json(ostream &os) const {
+    os << '[';
+    for (size_t i = 0; i < turns.size(); i++) {
+      const auto &t = turns[i];
+      os << (i == 0 ? "" : ",") << "\n  {\"turn\": " << i << ", \"beam_width\": " << t.beam_width
+          << ", \"pushed\": " << t.pushed << ", \"rejected\": " << t.rejected
+          << ", \"dedup_hits\": " << t.dedup_hits << ", \"probes\": " << t.probes
+          << ", \"max_probe\": " << t.max_probe << ", \"evictions\": " << t.evictions
+          << ", \"tour_length\": " << t.tour_length << ", \"dfs_microseconds\": " << t.dfs_microseconds
+          << ", \"update_microseconds\": " << t.update_microseconds << '}';
+    }
+    os << "\n]\n";
+  }
+};
+
+template<typename StateType>
+struct BeamCandidate {
+  int parent;
+  typename StateType::Action action;
+  typename StateType::Evaluator eval;
+  typename StateType::Hash hash;
+};
+
+// Candidates are stored as a struct of arrays. costs, hashes and slots are indexed by the
+// position in the beam and touched by every push. parents, actions and evals are indexed by
+// slot, written once per accepted push and handed to EulerTourTree without copying.
+template<typename StateType,
+  template<typename> class Selection = SegmentTreeSelection,
+  typename Statistics = NoStatistics,
+  template<typename, typename> class Map = HashMap>
+struct BeamSelector {
+  using Action = typename StateType::Action;
+  using Evaluator = typename StateType::Evaluator;
+  using Cost = typename Evaluator::Cost;
+  using Hash = typename StateType::Hash;
+  using Candidate = BeamCandidate<StateType>;
+
+  vector<Candidate> finished_candidates;
+  vector<Cost> costs;
+  vector<Hash> hashes;
+  vector<int> slots;
+  vector<int> parents;
+  vector<Action> actions;
+  vector<Evaluator> evals;
+  vector<int> free_slots;
+  int next_slot;
+  Selection<Cost> selection;
+  Map<Hash, int> hash_to_index;
+  size_t beam_width;
+  // with optimise, every finished candidate becomes the bound and a push whose cost is not
+  // below the bound is rejected before it reaches the hash map or the selection
+  bool optimise;
+  optional<Cost> bound;
+  [[no_unique_address]] typename Statistics::Counters counters;
+
+  explicit BeamSelector(size_t beam_width, size_t hash_map_capacity, const bool optimise = false)
+    : next_slot(0),
+      selection(beam_width),
+      hash_to_index(hash_map_capacity),
+      beam_width(beam_width),
+      optimise(optimise) {
+    reserve();
+  }
+
   void push(const Action &action, const Evaluator &eval, const Hash &hash, int parent, const bool finished) {
+    if constexpr (Statistics::enabled) ++counters.pushed;
     auto cost = eval.evaluate();
+    if (bound and not(cost < *bound)) {
+      if constexpr (Statistics::enabled) ++counters.rejected;
+      return;
+    }
     if (finished) {
       finished_candidates.emplace_back((Candidate){parent, action, eval, hash});
+      if (optimise) bound = cost;
       return;
     }
-    if (full and cost >= seg.all_prod().first) {
+    if (selection.rejects(cost)) {
+      if constexpr (Statistics::enabled) ++counters.rejected;
       return;
     }
     auto [valid, i] = hash_to_index.get_index(hash);
+    if constexpr (Statistics::enabled) {
+      const size_t probe = hash_to_index.distance(hash, i);
+      counters.probes += probe;
+      counters.max_probe = max(counters.max_probe, probe);
+    }
     if (valid) {
       int j = hash_to_index.get(i);
-      if (hash == candidates[j].hash) {
-        if (cost < costs[j].first) {
-          candidates[j] = (Candidate){parent, action, eval, hash};
-          costs[j].first = cost;
-          if (full) {
-            seg.set(j, costs[j]);
-          }
+      if (hash == hashes[j]) {
+        if constexpr (Statistics::enabled) ++counters.dedup_hits;
+        if (cost < costs[j]) {
+          store(slots[j], parent, action, eval);
+          costs[j] = cost;
+          selection.update(costs, j);
         }
         return;
       }
     }
-    if (full) {
-      int j = seg.all_prod().second;
+    if (int j = selection.evict(); j >= 0) {
+      if constexpr (Statistics::enabled) ++counters.evictions;
       hash_to_index.set(i, hash, j);
-      candidates[j] = (Candidate){parent, action, eval, hash};
-      costs[j].first = cost;
-      seg.set(j, costs[j]);
+      store(slots[j], parent, action, eval);
+      hashes[j] = hash;
+      costs[j] = cost;
+      selection.update(costs, j);
     } else {
-      hash_to_index.set(i, hash, static_cast<int>(candidates.size()));
-      costs.emplace_back(cost, static_cast<int>(candidates.size()));
-      candidates.emplace_back((Candidate){parent, action, eval, hash});
-      if (candidates.size() == beam_width) {
-        seg.build(costs);
-        full = true;
+      j = static_cast<int>(costs.size());
+      hash_to_index.set(i, hash, j);
+      int slot = next_slot;
+      if (free_slots.empty()) {
+        ++next_slot;
+      } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+      }
+      store(slot, parent, action, eval);
+      slots.emplace_back(slot);
+      hashes.emplace_back(hash);
+      costs.emplace_back(cost);
+      selection.update(costs, j);
+      if (selection.overflows(costs.size())) {
+        shrink();
+      }
+    }
+  }
+
+  // a candidate whose cost is at least lower_bound would be rejected by push
+  [[nodiscard]] bool rejects(const Cost &lower_bound, const bool finished) const {
+    if (bound and not(lower_bound < *bound)) return true;
+    return not finished and selection.rejects(lower_bound);
+  }
+
+  template<typename Build>
+  void push(const Action &action, const Cost &lower_bound, const Build &build, int parent, const bool finished) {
+    if (rejects(lower_bound, finished)) {
+      if constexpr (Statistics::enabled) {
+        ++counters.pushed;
+        ++counters.rejected;
       }
+      return;
     }
+    const auto &[eval, hash] = build();
+    push(action, eval, hash, parent, finished);
   }
 
-  [[nodiscard]] const vector<Candidate> &get_candidates() {
-    return candidates;
+  void shrink() {
+    const auto &keep = selection.shrink(costs);
+    if constexpr (Statistics::enabled) counters.evictions += costs.size() - keep.size();
+    hash_to_index.clear();
+    for (int k = 0, l = 0; k < static_cast<int>(costs.size()); k++) {
+      if (l < static_cast<int>(keep.size()) and keep[l] == k) {
+        costs[l] = costs[k];
+        hashes[l] = hashes[k];
+        slots[l] = slots[k];
+        hash_to_index.set(hash_to_index.get_index(hashes[l]).second, hashes[l], l);
+        ++l;
+      } else {
+        free_slots.emplace_back(slots[k]);
+      }
+    }
+    costs.resize(keep.size());
+    hashes.resize(keep.size());
+    slots.resize(keep.size());
+  }
+
+  void select() {
+    if (costs.size() > beam_width) {
+      shrink();
+    }
+  }
+
+  [[nodiscard]] size_t size() const {
+    return costs.size();
+  }
+
+  [[nodiscard]] size_t capacity() const {
+    return Selection<Cost>::capacity(beam_width);
+  }
+
+  [[nodiscard]] Candidate get_candidate(const int j) const {
+    const int slot = slots[j];
+    return {parents[slot], actions[slot], evals[slot], hashes[j]};
   }
 
   [[nodiscard]] vector<Candidate> get_finished_candidate() const {
     return finished_candidates;
   }
 
+  [[nodiscard]] Candidate get_best_finished_candidate() const {
+    assert(not finished_candidates.empty());
+    return *ranges::min_element(finished_candidates, {}, [](const Candidate &c) { return c.eval.evaluate(); });
+  }
+
   [[nodiscard]] Candidate get_best_candidate() const {
-    assert(not candidates.empty());
-    return candidates[ranges::min_element(costs) - costs.begin()];
+    assert(not costs.empty());
+    return get_candidate(static_cast<int>(ranges::min_element(costs) - costs.begin()));
   }
 
   [[nodiscard]] bool is_finished() const {
     return not finished_candidates.empty();
   }
 
+  void set_beam_width(const size_t width) {
+    assert(costs.empty());
+    if (width != beam_width) {
+      selection.set_beam_width(width);
+      beam_width = width;
+      reserve();
+    }
+  }
+
+  void merge(const BeamSelector &other) {
+    for (const auto &candidate : other.finished_candidates) {
+      finished_candidates.emplace_back(candidate);
+    }
+    if (other.bound and (not bound or *other.bound < *bound)) {
+      bound = other.bound;
+    }
+    // only the pushes of the workers are counted, not their replay into this selector
+    [[maybe_unused]] const auto saved = counters;
+    for (int j = 0; j < static_cast<int>(other.size()); j++) {
+      const int slot = other.slots[j];
+      push(other.actions[slot], other.evals[slot], other.hashes[j], other.parents[slot], false);
+    }
+    if constexpr (Statistics::enabled) {
+      counters = saved;
+      counters += other.counters;
+    }
+  }
+
   void clear() {
-    candidates.clear();
-    hash_to_index.clear();
+    finished_candidates.clear();
     costs.clear();
-    full = false;
+    hashes.clear();
+    slots.clear();
+    free_slots.clear();
+    next_slot = 0;
+    hash_to_index.clear();
+    selection.clear();
+    counters = {};
   }
+
+  private:
+    template<typename T>
+    static void store(vector<T> &v, const int slot, const T &x) {
+      if (slot < static_cast<int>(v.size())) {
+        v[slot] = x;
+      } else {
+        v.emplace_back(x);
+      }
+    }
+
+    void store(const int slot, const int parent, const Action &action, const Evaluator &eval) {
+      store(parents, slot, parent);
+      store(actions, slot, action);
+      store(evals, slot, eval);
+    }
+
+    void reserve() {
+      free_slots.reserve(capacity());
+      costs.reserve(capacity());
+      hashes.reserve(capacity());
+      slots.reserve(capacity());
+      parents.reserve(capacity());
+      actions.reserve(capacity());
+      evals.reserve(capacity());
+    }
 };
 
+// The sink handed to State::expand for the children of parent. It takes both forms of BeamPush.
+template<typename Selector>
+struct SelectorPush {
+  using Action = typename Selector::Action;
+  using Evaluator = typename Selector::Evaluator;
+  using Cost = typename Selector::Cost;
+  using Hash = typename Selector::Hash;
+
+  Selector &selector;
+  int parent;
+
+  void operator()(const Action &a, const Evaluator &e, const Hash &h, bool f) const {
+    selector.push(a, e, h, parent, f);
+  }
+
+  template<typename Build>
+  void operator()(const Action &a, const Cost &lower_bound, const Build &build, bool f) const {
+    selector.push(a, lower_bound, build, parent, f);
+  }
+};
+
+// Threads that live for a whole search and wait on a barrier between the turns. run(job) calls
+// job(t) for every t < size(), t = 0 on the calling thread, and returns when all have finished.
+// The job is referenced, not copied, so handing one over does not allocate.
+struct WorkerPool {
+  explicit WorkerPool(const size_t num_threads) : sync(static_cast<ptrdiff_t>(num_threads)) {
+    for (size_t t = 1; t < num_threads; t++) {
+      threads.emplace_back([this, t] {
+        while (true) {
+          sync.arrive_and_wait();
+          if (stop) return;
+          call(job, t);
+          sync.arrive_and_wait();
+        }
+      });
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  ~WorkerPool() {
+    stop = true;
+    sync.arrive_and_wait();
+    for (auto &th : threads) {
+      th.join();
+    }
+  }
+
+  template<typename F>
+  void run(const F &f) {
+    job = &f;
+    call = [](const void *job, const size_t t) { (*static_cast<const F *>(job))(t); };
+    sync.arrive_and_wait();
+    f(0);
+    sync.arrive_and_wait();
+  }
+
+  [[nodiscard]] size_t size() const {
+    return threads.size() + 1;
+  }
+
+  private:
+    barrier<> sync;
+    const void *job = nullptr;
+    void (*call)(const void *, size_t) = nullptr;
+    bool stop = false;
+    vector<thread> threads;
+};
+
+// The tour is a sequence of 32-bit opcodes. The upper two bits select the operation and the
+// lower bits hold a run length or a leaf index:
+//   ENTER n : apply the next n actions of the pool
+//   LEAVE n : roll back the n innermost applied actions
+//   LEAF  i : apply the next action of the pool, expand leaf i and roll it back
+// Every edge stores its action once in the pool, and a single-child chain anywhere in the tree
+// collapses into one ENTER and one LEAVE.
 template<typename StateType>
 struct EulerTourTree {
   using Action = typename StateType::Action;
   using Evaluator = typename StateType::Evaluator;
   using Hash = typename StateType::Hash;
-  using Candidate = typename BeamSelector<StateType>::Candidate;
 
-  using Edge = pair<int, Action>;
-  using Vertex = pair<Evaluator, Hash>;
+  static constexpr uint32_t ENTER = 0u << 30, LEAVE = 1u << 30, LEAF = 2u << 30, OP = 3u << 30;
 
-  explicit EulerTourTree(StateType state, const int beam_width) : state(move(state)), buckets(beam_width) {
+  explicit EulerTourTree(StateType state, const int beam_width) : state(move(state)) {
+    bucket_begin.reserve(beam_width + 1);
+    bucket_slots.reserve(beam_width);
   }
 
-  void dfs(BeamSelector<StateType> &selector) {
+  // Sizes every buffer for beam_width leaves at depth max_turn, so that such a search does not
+  // allocate. A tour of B leaves has at most 3 B opcodes (an ENTER and a LEAVE run around each
+  // leaf) and B * depth edges, plus one chain being entered while the next tour is built.
+  void reserve(const size_t beam_width, const size_t max_turn) {
+    for (auto *tour : {&curr_tour, &next_tour}) {
+      tour->reserve(3 * beam_width + 1);
+    }
+    for (auto *actions : {&curr_actions, &next_actions}) {
+      actions->reserve((beam_width + 1) * max_turn);
+    }
+    stack.reserve(max_turn);
+    road.reserve(max_turn);
+    leaf_evals.reserve(beam_width);
+    leaf_hashes.reserve(beam_width);
+  }
+
+  template<typename Selector>
+  void dfs(Selector &selector) {
     if (curr_tour.empty()) {
       const auto &[action, eval, hash] = state.make_initial_node();
-      state.expand(action,
-                   eval,
-                   hash,
-                   [&](const Action &a, const Evaluator &e, const Hash &h, bool f) {
-                     return selector.push(a, e, h, 0, f);
-                   });
+      const SelectorPush<Selector> push{selector, 0};
+      state.expand(action, eval, hash, push);
       return;
     }
 
-    for (const auto &[i, action] : curr_tour) {
-      if (i >= 0) {
+    stack.clear();
+    dfs(state, selector, 0, curr_tour.size(), 0, stack);
+  }
+
+  template<typename Selector>
+  void dfs(StateType &state,
+           Selector &selector,
+           const size_t first,
+           const size_t last,
+           uint32_t cursor,
+           vector<uint32_t> &stack) const {
+    for (size_t k = first; k < last; k++) {
+      const uint32_t op = curr_tour[k] & OP, arg = curr_tour[k] & ~OP;
+      if (op == LEAF) {
+        const auto &action = curr_actions[cursor++];
         state.apply(action);
-        const auto &[eval, hash] = leaves[i];
-        state.expand(action,
-                     eval,
-                     hash,
-                     [&](const Action &a, const Evaluator &e, const Hash &h, bool f) {
-                       return selector.push(a, e, h, i, f);
-                     });
+        const auto &eval = leaf_evals[arg];
+        const auto &hash = leaf_hashes[arg];
+        const SelectorPush<Selector> push{selector, static_cast<int>(arg)};
+        state.expand(action, eval, hash, push);
         state.rollback(action);
-      } else if (i == -1) {
-        state.apply(action);
+      } else if (op == ENTER) {
+        for (uint32_t n = 0; n < arg; n++) {
+          stack.emplace_back(cursor);
+          state.apply(curr_actions[cursor++]);
+        }
       } else {
-        state.rollback(action);
+        for (uint32_t n = 0; n < arg; n++) {
+          state.rollback(curr_actions[stack.back()]);
+          stack.pop_back();
+        }
       }
     }
   }
 
-  void update(const vector<Candidate> &candidates) {
-    leaves.clear();
+  struct Range {
+    vector<uint32_t> path;
+    size_t first, last;
+    uint32_t cursor;
+  };
 
-    if (curr_tour.empty()) {
-      for (const auto &candidate : candidates) {
-        curr_tour.emplace_back(static_cast<int>(leaves.size()), candidate.action);
-        leaves.emplace_back(candidate.eval, candidate.hash);
+  // cuts the tour into at most parts ranges holding about as many leaves each; path is the
+  // stack of pool positions entered before the range begins. The buffers are kept between turns.
+  void split(const size_t parts) {
+    ranges.resize(parts);
+    ranges[0].path.clear();
+    ranges[0].first = 0;
+    ranges[0].cursor = 0;
+    split_path.clear();
+    size_t count = 1, leaf_count = 0;
+    uint32_t cursor = 0;
+    for (size_t k = 0; k < curr_tour.size() and count < parts; k++) {
+      const uint32_t op = curr_tour[k] & OP, arg = curr_tour[k] & ~OP;
+      if (op == LEAF) {
+        ++cursor;
+        if (++leaf_count * parts >= num_leaves * count) {
+          ranges[count - 1].last = k + 1;
+          copy_path(split_path, ranges[count].path);
+          ranges[count].first = k + 1;
+          ranges[count].cursor = cursor;
+          ++count;
+        }
+      } else if (op == ENTER) {
+        for (uint32_t n = 0; n < arg; n++) {
+          split_path.emplace_back(cursor++);
+        }
+      } else {
+        split_path.resize(split_path.size() - arg);
       }
+    }
+    ranges[count - 1].last = curr_tour.size();
+    num_ranges = count;
+  }
+
+  // Worker 0 walks the first range on state, whose path is empty. Every other worker keeps a
+  // copy of the state for the whole search: it catches up with the actions trimmed into road
+  // since the last turn, enters the path of its range and rolls it back at the end.
+  template<typename Selector>
+  void parallel_dfs(Selector &selector, vector<Selector> &workers) {
+    if (curr_tour.empty()) {
+      dfs(selector);
       return;
     }
 
-    for (int i = 0; i < static_cast<int>(candidates.size()); i++) {
-      buckets[candidates[i].parent].emplace_back(i);
+    if (not worker_pool or worker_pool->size() != workers.size()) {
+      worker_pool.reset();
+      worker_pool = make_unique<WorkerPool>(workers.size());
+    }
+    if (replicas.size() + 1 != workers.size()) {
+      replicas.assign(workers.size() - 1, Replica{state, road.size(), {}});
+    }
+    split(workers.size());
+    for (auto &worker : workers) {
+      worker.bound = selector.bound;
+    }
+    worker_pool->run([&](const size_t t) {
+      if (t >= num_ranges) return;
+      auto &local = t == 0 ? state : replicas[t - 1].state;
+      auto &path = t == 0 ? stack : replicas[t - 1].path;
+      if (t > 0) {
+        for (auto &applied = replicas[t - 1].applied; applied < road.size(); applied++) {
+          local.apply(road[applied]);
+        }
+      }
+      copy_path(ranges[t].path, path);
+      for (const auto &i : path) {
+        local.apply(curr_actions[i]);
+      }
+      dfs(local, workers[t], ranges[t].first, ranges[t].last, ranges[t].cursor, path);
+      for (; not path.empty(); path.pop_back()) {
+        local.rollback(curr_actions[path.back()]);
+      }
+    });
+    for (size_t t = 0; t < num_ranges; t++) {
+      selector.merge(workers[t]);
+      workers[t].clear();
     }
+  }
 
-    auto it = curr_tour.begin();
+  // leaf indices of the next turn are the slots of the selector, so the evaluators are taken
+  // over by swapping the arena instead of being copied
+  template<typename Selector>
+  void update(Selector &selector) {
+    const int n = static_cast<int>(selector.size());
+    num_leaves = n;
+    // the current leaves and the parents of the new ones are slots of the last turn, which
+    // may have had a wider beam than this one
+    const size_t parent_capacity = exchange(leaf_capacity, selector.capacity());
+    leaf_hashes.resize(selector.capacity());
+    for (int j = 0; j < n; j++) {
+      leaf_hashes[selector.slots[j]] = selector.hashes[j];
+    }
+    leaf_evals.swap(selector.evals);
+    const auto &actions = selector.actions;
 
-    while (it->first == -1 and it->second == curr_tour.back().second) {
-      const auto &action = it++->second;
-      state.apply(action);
-      road.emplace_back(action);
-      curr_tour.pop_back();
+    if (curr_tour.empty()) {
+      for (int j = 0; j < n; j++) {
+        const int slot = selector.slots[j];
+        emit_leaf(slot, actions[slot]);
+      }
+      curr_tour.swap(next_tour);
+      curr_actions.swap(next_actions);
+      return;
     }
 
-    while (it != curr_tour.end()) {
-      const auto &[leaf_index, action] = *it++;
-      if (leaf_index >= 0) {
-        if (buckets[leaf_index].empty()) {
+    // the children of leaf i are bucket_slots[bucket_begin[i], bucket_begin[i + 1]), in beam order
+    bucket_begin.assign(max(parent_capacity, selector.capacity()) + 1, 0);
+    for (int j = 0; j < n; j++) {
+      ++bucket_begin[selector.parents[selector.slots[j]] + 1];
+    }
+    partial_sum(bucket_begin.begin(), bucket_begin.end(), bucket_begin.begin());
+    bucket_slots.resize(n);
+    for (int j = 0; j < n; j++) {
+      const int slot = selector.slots[j];
+      bucket_slots[bucket_begin[selector.parents[slot]]++] = slot;
+    }
+    // the fill moved every begin to the next bucket
+    for (size_t i = bucket_begin.size() - 1; i > 0; i--) {
+      bucket_begin[i] = bucket_begin[i - 1];
+    }
+    bucket_begin[0] = 0;
+
+    uint32_t cursor = trim();
+    for (const uint32_t code : curr_tour) {
+      const uint32_t op = code & OP, arg = code & ~OP;
+      if (op == LEAF) {
+        const auto &action = curr_actions[cursor++];
+        if (bucket_begin[arg] == bucket_begin[arg + 1]) {
           continue;
         }
-        next_tour.emplace_back(-1, action);
-        for (int i : buckets[leaf_index]) {
-          int j = static_cast<int>(leaves.size());
-          next_tour.emplace_back(j, candidates[i].action);
-          leaves.emplace_back(candidates[i].eval, candidates[i].hash);
+        emit_enter(action);
+        for (int k = bucket_begin[arg]; k < bucket_begin[arg + 1]; k++) {
+          emit_leaf(bucket_slots[k], actions[bucket_slots[k]]);
+        }
+        emit_leave();
+      } else if (op == ENTER) {
+        for (uint32_t k = 0; k < arg; k++) {
+          emit_enter(curr_actions[cursor++]);
         }
-        buckets[leaf_index].clear();
-        next_tour.emplace_back(-2, action);
-      } else if (leaf_index == -1) {
-        next_tour.emplace_back(-1, action);
-      } else if (next_tour.back().first == -1) {
-        next_tour.pop_back();
       } else {
-        next_tour.emplace_back(-2, action);
+        for (uint32_t k = 0; k < arg; k++) {
+          emit_leave();
+        }
       }
     }
     curr_tour.swap(next_tour);
+    curr_actions.swap(next_actions);
     next_tour.clear();
+    next_actions.clear();
+  }
+
+  [[nodiscard]] size_t tour_length() const {
+    return curr_tour.size();
   }
 
   [[nodiscard]] vector<Action> restore(int parent, int turn) const {
     vector<Action> ret = road;
     ret.reserve(turn);
-    for (const auto &[leaf_index, action] : curr_tour) {
-      if (leaf_index >= 0) {
-        if (leaf_index == parent) {
-          ret.push_back(action);
+    uint32_t cursor = 0;
+    for (const uint32_t code : curr_tour) {
+      const uint32_t op = code & OP, arg = code & ~OP;
+      if (op == LEAF) {
+        if (static_cast<int>(arg) == parent) {
+          ret.push_back(curr_actions[cursor]);
           return ret;
         }
-      } else if (leaf_index == -1) {
-        ret.push_back(action);
+        ++cursor;
+      } else if (op == ENTER) {
+        for (uint32_t k = 0; k < arg; k++) {
+          ret.push_back(curr_actions[cursor++]);
+        }
       } else {
-        ret.pop_back();
+        ret.resize(ret.size() - arg);
       }
     }
     return {};
@@ -255,48 +933,317 @@ struct EulerTourTree {
 
   StateType state;
   vector<Action> road;
-  vector<Edge> curr_tour, next_tour;
-  vector<vector<int> > buckets;
-  vector<Vertex> leaves;
+  vector<uint32_t> curr_tour, next_tour, stack;
+  vector<Action> curr_actions, next_actions;
+  vector<int> bucket_begin, bucket_slots;
+  vector<Evaluator> leaf_evals;
+  vector<Hash> leaf_hashes;
+  size_t num_leaves = 0, leaf_capacity = 0;
+  // handed from one pass to the next by time_limited_euler_tour_beam_search
+  unique_ptr<WorkerPool> worker_pool;
+
+  private:
+    struct Replica {
+      StateType state;
+      size_t applied;
+      vector<uint32_t> path;
+    };
+
+    vector<Range> ranges;
+    vector<uint32_t> split_path;
+    size_t num_ranges = 0;
+    vector<Replica> replicas;
+
+    // the paths grow by about one action per turn, so their capacity is doubled ahead
+    static void copy_path(const vector<uint32_t> &from, vector<uint32_t> &to) {
+      if (to.capacity() < from.size()) {
+        to.reserve(2 * from.size());
+      }
+      to.assign(from.begin(), from.end());
+    }
+
+    void emit_enter(const Action &action) {
+      next_actions.emplace_back(action);
+      if (not next_tour.empty() and (next_tour.back() & OP) == ENTER) {
+        ++next_tour.back();
+      } else {
+        next_tour.emplace_back(ENTER | 1);
+      }
+    }
+
+    void emit_leave() {
+      if ((next_tour.back() & OP) == ENTER) {
+        // the subtree became empty
+        next_actions.pop_back();
+        if (--next_tour.back() == ENTER) {
+          next_tour.pop_back();
+        }
+      } else if ((next_tour.back() & OP) == LEAVE) {
+        ++next_tour.back();
+      } else {
+        next_tour.emplace_back(LEAVE | 1);
+      }
+    }
+
+    void emit_leaf(const int slot, const Action &action) {
+      next_actions.emplace_back(action);
+      next_tour.emplace_back(LEAF | static_cast<uint32_t>(slot));
+    }
+
+    // moves the chain of edges enclosing the whole tour into road and returns the pool
+    // position of the first action that is still part of the tour
+    uint32_t trim() {
+      if ((curr_tour.front() & OP) != ENTER or (curr_tour.back() & OP) != LEAVE) {
+        return 0;
+      }
+      uint32_t chain = curr_tour.front() & ~OP, depth = chain;
+      for (size_t k = 1; k + 1 < curr_tour.size() and chain > 0; k++) {
+        const uint32_t op = curr_tour[k] & OP, arg = curr_tour[k] & ~OP;
+        if (op == ENTER) {
+          depth += arg;
+        } else if (op == LEAVE) {
+          depth -= arg;
+          chain = min(chain, depth);
+        }
+      }
+      for (uint32_t k = 0; k < chain; k++) {
+        state.apply(curr_actions[k]);
+        road.emplace_back(curr_actions[k]);
+      }
+      curr_tour.front() -= chain;
+      curr_tour.back() -= chain;
+      return chain;
+    }
 };
 
-template<BeamState State>
-vector<typename State::Action> euler_tour_beam_search(const State &state,
-                                                      const size_t max_turn,
-                                                      size_t beam_width,
-                                                      size_t hash_map_capacity = 0) {
-  if (hash_map_capacity == 0) {
-    hash_map_capacity = 16 * 3 * beam_width;
-  }
+template<typename State>
+struct BeamSearchResult {
+  vector<typename State::Action> path;
+  typename State::Evaluator::Cost cost;
+  bool finished;
 
-  EulerTourTree<State> tree(state, beam_width);
-  BeamSelector<State> selector(beam_width, hash_map_capacity);
+  [[nodiscard]] bool is_better_than(const BeamSearchResult &other) const {
+    if (finished != other.finished) return finished;
+    if (not finished and path.size() != other.path.size()) return path.size() > other.path.size();
+    return cost < other.cost;
+  }
+};
 
+// next_beam_width(turn, expanded) returns the beam width of the next turn, or 0 to stop
+// and return the best partial path. expanded is the number of nodes expanded this turn.
+// If selector.optimise, finished candidates do not stop the search: the best one is
+// restored while the tree still holds its parent, and returned once the beam runs out.
+// Tree is EulerTourTree or any type with the same dfs / parallel_dfs / update / restore.
+template<typename State, template<typename> class Tree, typename Selector, typename F, typename Statistics>
+BeamSearchResult<State> run_beam_search(Tree<State> &tree,
+                                        Selector &selector,
+                                        vector<Selector> &workers,
+                                        const size_t max_turn,
+                                        const F &next_beam_width,
+                                        Statistics *statistics) {
+  optional<BeamSearchResult<State> > best;
   for (size_t turn = 0; turn < max_turn; turn++) {
-    tree.dfs(selector);
+    const size_t expanded = turn == 0 ? 1 : tree.num_leaves;
+    [[maybe_unused]] int64_t start = 0;
+    if constexpr (Statistics::enabled) {
+      start = statistics->timer.get_microseconds();
+    }
+    if (workers.empty()) {
+      tree.dfs(selector);
+    } else {
+      tree.parallel_dfs(selector, workers);
+    }
+    if constexpr (Statistics::enabled) {
+      typename Statistics::Turn record;
+      static_cast<typename Statistics::Counters &>(record) = selector.counters;
+      record.beam_width = selector.beam_width;
+      record.tour_length = tree.tour_length();
+      record.dfs_microseconds = statistics->timer.get_microseconds() - start;
+      statistics->turns.emplace_back(record);
+    }
 
     if (selector.is_finished()) {
-      auto finished = selector.get_finished_candidate()[0];
+      auto finished = selector.optimise ? selector.get_best_finished_candidate() : selector.get_finished_candidate()[0];
       auto path = tree.restore(finished.parent, turn + 1);
       path.emplace_back(finished.action);
-      return path;
+      if (not selector.optimise) {
+        return {path, finished.eval.evaluate(), true};
+      }
+      best = {path, finished.eval.evaluate(), true};
     }
 
-    const auto &candidates = selector.get_candidates();
-    if (candidates.empty()) {
-      return {};
+    selector.select();
+    if (selector.size() == 0) {
+      if (best) return *best;
+      return {{}, {}, false};
     }
 
-    if (turn + 1 == max_turn) {
-      auto best = selector.get_best_candidate();
-      auto path = tree.restore(best.parent, turn + 1);
-      path.emplace_back(best.action);
-      return path;
+    const size_t width = turn + 1 == max_turn ? 0 : next_beam_width(turn + 1, expanded);
+    if (width == 0) {
+      if (best) return *best;
+      auto candidate = selector.get_best_candidate();
+      auto path = tree.restore(candidate.parent, turn + 1);
+      path.emplace_back(candidate.action);
+      return {path, candidate.eval.evaluate(), false};
     }
 
-    tree.update(candidates);
+    if constexpr (Statistics::enabled) {
+      start = statistics->timer.get_microseconds();
+      tree.update(selector);
+      statistics->turns.back().update_microseconds = statistics->timer.get_microseconds() - start;
+    } else {
+      tree.update(selector);
+    }
     selector.clear();
+    selector.set_beam_width(width);
+    for (auto &worker : workers) {
+      worker.set_beam_width(width);
+    }
+  }
+  if (best) return *best;
+  return {{}, {}, false};
+}
+
+template<typename State,
+  template<typename> class Selection = SegmentTreeSelection,
+  typename Statistics = NoStatistics,
+  template<typename, typename> class Map = HashMap>
+  requires BeamState<State> or InlineBeamState<State>
+vector<typename State::Action> euler_tour_beam_search(const State &state,
+                                                      const size_t max_turn,
+                                                      size_t beam_width,
+                                                      size_t hash_map_capacity = 0,
+                                                      const size_t num_threads = 1,
+                                                      Statistics *statistics = nullptr) {
+  if (hash_map_capacity == 0) {
+    hash_map_capacity = 16 * 3 * beam_width;
+  }
+
+  EulerTourTree<State> tree(state, beam_width);
+  BeamSelector<State, Selection, Statistics, Map> selector(beam_width, hash_map_capacity);
+  vector<BeamSelector<State, Selection, Statistics, Map> > workers;
+  if (num_threads > 1) {
+    workers.assign(num_threads, BeamSelector<State, Selection, Statistics, Map>(beam_width, hash_map_capacity));
+  }
+
+  const auto next_beam_width = [&](size_t, size_t) { return beam_width; };
+  return run_beam_search(tree, selector, workers, max_turn, next_beam_width, statistics).path;
+}
+
+// Keeps searching after the first finished candidate and returns the finished path of the
+// lowest cost, or the best partial path if nothing finished within max_turn.
+// The cost of a finished candidate bounds the search: a push whose cost is not below it is
+// dropped, so Evaluator::evaluate() should never decrease along a path.
+template<typename State,
+  template<typename> class Selection = SegmentTreeSelection,
+  typename Statistics = NoStatistics,
+  template<typename, typename> class Map = HashMap>
+  requires BeamState<State> or InlineBeamState<State>
+vector<typename State::Action> optimising_euler_tour_beam_search(const State &state,
+                                                                 const size_t max_turn,
+                                                                 size_t beam_width,
+                                                                 size_t hash_map_capacity = 0,
+                                                                 const size_t num_threads = 1,
+                                                                 Statistics *statistics = nullptr) {
+  if (hash_map_capacity == 0) {
+    hash_map_capacity = 16 * 3 * beam_width;
+  }
+
+  EulerTourTree<State> tree(state, beam_width);
+  BeamSelector<State, Selection, Statistics, Map> selector(beam_width, hash_map_capacity, true);
+  vector<BeamSelector<State, Selection, Statistics, Map> > workers;
+  if (num_threads > 1) {
+    workers.assign(num_threads, BeamSelector<State, Selection, Statistics, Map>(beam_width, hash_map_capacity, true));
+  }
+
+  const auto next_beam_width = [&](size_t, size_t) { return beam_width; };
+  return run_beam_search(tree, selector, workers, max_turn, next_beam_width, statistics).path;
+}
+
+template<typename State,
+  template<typename> class Selection = SegmentTreeSelection,
+  typename Statistics = NoStatistics,
+  template<typename, typename> class Map = HashMap>
+  requires BeamState<State> or InlineBeamState<State>
+vector<typename State::Action> time_limited_euler_tour_beam_search(const State &state,
+                                                                   const size_t max_turn,
+                                                                   const int end_milliseconds,
+                                                                   const size_t max_beam_width,
+                                                                   const size_t initial_beam_width = 1,
+                                                                   size_t hash_map_capacity = 0,
+                                                                   const size_t num_threads = 1,
+                                                                   Statistics *statistics = nullptr) {
+  if (hash_map_capacity == 0) {
+    hash_map_capacity = 16 * 3 * max_beam_width;
+  }
+
+  // The budget runs from the call. A pass of width 1 still inserts every candidate that beats the
+  // one it holds, and the entries it drops stay in the table until the next turn, so the table
+  // never gets fewer than 1 << 16 slots, far above any branching factor. The selectors are rebuilt
+  // only when a pass needs a larger table; allocating the full one up front costs ~10 ms.
+  const Timer timer;
+  const auto end_time = static_cast<int64_t>(end_milliseconds) * 1000;
+  optional<BeamSearchResult<State> > best;
+  const size_t min_capacity = min<size_t>(hash_map_capacity, 1 << 16);
+  size_t capacity = 0;
+  optional<BeamSelector<State, Selection, Statistics, Map> > selector;
+  vector<BeamSelector<State, Selection, Statistics, Map> > workers;
+  unique_ptr<WorkerPool> worker_pool;
+  for (size_t beam_width = min(initial_beam_width, max_beam_width);; beam_width = min(2 * beam_width, max_beam_width)) {
+    const auto pass_start = timer.get_microseconds();
+    EulerTourTree<State> tree(state, beam_width);
+    tree.worker_pool = move(worker_pool);
+    if (const size_t needed = max(hash_map_capacity * beam_width / max_beam_width, min_capacity); needed > capacity) {
+      capacity = needed;
+      selector.emplace(beam_width, capacity);
+      workers.assign(num_threads > 1 ? num_threads : 0, *selector);
+    } else {
+      selector->clear();
+      selector->set_beam_width(beam_width);
+      for (auto &worker : workers) {
+        worker.clear();
+        worker.set_beam_width(beam_width);
+      }
+    }
+
+    bool limited = false;
+    int64_t last_time = timer.get_microseconds();
+    double time_sum = 0, node_sum = 0;
+    auto result = run_beam_search(tree, *selector, workers, max_turn, [&](size_t turn, size_t expanded) -> size_t {
+      const auto now = timer.get_microseconds();
+      // the cost per node grows with the tour, so follow it with sums that decay per turn
+      const double cost = static_cast<double>(now - last_time) / expanded;
+      time_sum = 0.9 * time_sum + static_cast<double>(now - last_time);
+      node_sum = 0.9 * node_sum + static_cast<double>(expanded);
+      last_time = now;
+      const double per_node = time_sum / node_sum, remaining = static_cast<double>(end_time - now);
+      // the next turn expands the candidates just selected, whatever width is returned now, and
+      // is started only with half as much time again left as it is predicted to take
+      if (1.5 * max(per_node, cost) * static_cast<double>(selector->size()) >= remaining) {
+        limited = true;
+        return 0;
+      }
+      // the first turns of a pass pay for the fresh buffers, so narrow only with the beam full
+      if (expanded < beam_width) {
+        return beam_width;
+      }
+      const double affordable = remaining / (max_turn - turn) / max(per_node, 1e-3);
+      if (affordable < static_cast<double>(beam_width)) {
+        limited = true;
+        return max<size_t>(1, static_cast<size_t>(affordable));
+      }
+      return beam_width;
+    }, statistics);
+    worker_pool = move(tree.worker_pool);
+    if (not best or result.is_better_than(*best)) {
+      best = move(result);
+    }
+    // a pass of twice the width takes about twice as long, so start it only with half of that left
+    const auto now = timer.get_microseconds();
+    if (limited or beam_width == max_beam_width or end_time - now < now - pass_start) {
+      break;
+    }
   }
-  return {};
+  return best->path;
 }
 }
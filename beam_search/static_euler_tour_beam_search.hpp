@@ -0,0 +1,97 @@
+namespace BeamSearch {
+// SegmentTreeSelection for a compile-time beam width, with the tree and the costs in std::array.
+template<typename Cost, size_t BeamWidth>
+struct StaticSegmentTreeSelection {
+  using T = pair<Cost, int>;
+  using monoid = typename SegmentTreeSelection<Cost>::monoid;
+
+  StaticSegmentTree<monoid, BeamWidth> seg;
+  array<T, BeamWidth> costs;
+  bool full;
+
+  explicit StaticSegmentTreeSelection([[maybe_unused]] const size_t beam_width) : full(false) {
+    assert(beam_width == BeamWidth);
+  }
+
+  static constexpr size_t capacity(size_t) {
+    return BeamWidth;
+  }
+
+  void set_beam_width([[maybe_unused]] const size_t width) {
+    assert(width == BeamWidth);
+  }
+
+  [[nodiscard]] bool rejects(const Cost &cost) const {
+    return full and cost >= seg.all_prod().first;
+  }
+
+  [[nodiscard]] int evict() const {
+    return full ? seg.all_prod().second : -1;
+  }
+
+  void update(const vector<Cost> &c, const int j) {
+    if (full) {
+      seg.set(j, {c[j], j});
+    } else if (c.size() == BeamWidth) {
+      for (int k = 0; k < static_cast<int>(BeamWidth); k++) {
+        costs[k] = {c[k], k};
+      }
+      seg.build(costs);
+      full = true;
+    }
+  }
+
+  [[nodiscard]] bool overflows(size_t) const {
+    return false;
+  }
+
+  const vector<int> &shrink(const vector<Cost> &) {
+    assert(false);
+    static const vector<int> none;
+    return none;
+  }
+
+  void clear() {
+    full = false;
+  }
+};
+
+template<size_t BeamWidth>
+struct StaticSegmentTreeSelectionOf {
+  template<typename Cost>
+  using type = StaticSegmentTreeSelection<Cost, BeamWidth>;
+};
+
+// euler_tour_beam_search with the beam width and the hash map capacity fixed at compile time.
+// The selection policy, its segment tree and the hash map are std::arrays allocated once with
+// the selector; the buffers of the tour are reserved for BeamWidth leaves at depth max_turn.
+template<size_t BeamWidth,
+  size_t HashMapCapacity = bit_ceil(16 * 3 * BeamWidth),
+  typename State,
+  typename Statistics = NoStatistics>
+  requires BeamState<State> or InlineBeamState<State>
+vector<typename State::Action> static_euler_tour_beam_search(const State &state,
+                                                             const size_t max_turn,
+                                                             const size_t num_threads = 1,
+                                                             Statistics *statistics = nullptr) {
+  using Selector = BeamSelector<State,
+    StaticSegmentTreeSelectionOf<BeamWidth>::template type,
+    Statistics,
+    StaticHashMapOf<HashMapCapacity>::template type>;
+
+  EulerTourTree<State> tree(state, BeamWidth);
+  tree.reserve(BeamWidth, max_turn);
+  // the arrays are too large for the stack
+  const auto selector = make_unique<Selector>(BeamWidth, HashMapCapacity);
+  vector<Selector> workers;
+  if (num_threads > 1) {
+    workers.reserve(num_threads);
+    for (size_t t = 0; t < num_threads; t++) {
+      workers.emplace_back(BeamWidth, HashMapCapacity);
+    }
+  }
+
+  const auto next_beam_width = [](size_t, size_t) { return BeamWidth; };
+  return run_beam_search(tree, *selector, workers, max_turn, next_beam_width, statistics).path;
+}
+}
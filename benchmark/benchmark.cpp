@@ -0,0 +1,502 @@
+// g++ -std=gnu++20 -O2 -pthread benchmark/benchmark.cpp -o benchmark/benchmark
+// ./benchmark/benchmark [filter]
+
+#include <bits/stdc++.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "../timer/timer.hpp"
+#include "../timer/tsc_timer.hpp"
+#include "../random/xor_shift.hpp"
+#include "../random/batch_xor_shift.hpp"
+#include "../hash/hash_map.hpp"
+#include "../hash/swiss_hash_map.hpp"
+#include "../hash/static_hash_map.hpp"
+#include "../hash/zobrist.hpp"
+#include "../segment_tree/segment_tree.hpp"
+#include "../segment_tree/static_segment_tree.hpp"
+#include "../beam_search/euler_tour_beam_search.hpp"
+#include "../beam_search/copy_beam_search.hpp"
+#include "../beam_search/static_euler_tour_beam_search.hpp"
+#include "../move_stack/move_stack.hpp"
+#include "../minimax/minimax.hpp"
+#include "../alphabeta/transposition_table.hpp"
+#include "../alphabeta/alphabeta.hpp"
+#include "../alphabeta/iterative_deepening.hpp"
+#include "../mcts/mcts.hpp"
+#include "../simulated_annealing/simulated_annealing.hpp"
+#include "../simulated_annealing/parallel_tempering.hpp"
+#include "../hill_climbing/hill_climbing.hpp"
+#include "../local_search/local_search.hpp"
+#include "problems.hpp"
+
+namespace Benchmark {
+// heap allocations of the current run, counted by the replaced operator new below
+inline atomic<size_t> allocations = 0;
+
+// every form of operator new and delete goes through this pair; they are not inlined, so GCC
+// does not pair the malloc of one with the free of another replaced operator
+[[gnu::noinline]] inline void *allocate(const size_t size, const size_t alignment, const bool nothrow) {
+  allocations.fetch_add(1, memory_order_relaxed);
+  void *p = alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+              ? malloc(max<size_t>(size, 1))
+              : aligned_alloc(alignment, (max<size_t>(size, 1) + alignment - 1) / alignment * alignment);
+  if (not p and not nothrow) throw bad_alloc();
+  return p;
+}
+
+[[gnu::noinline]] inline void deallocate(void *p) noexcept {
+  free(p);
+}
+}
+
+void *operator new(const size_t size) { return Benchmark::allocate(size, 0, false); }
+void *operator new[](const size_t size) { return Benchmark::allocate(size, 0, false); }
+void *operator new(const size_t size, const nothrow_t &) noexcept { return Benchmark::allocate(size, 0, true); }
+void *operator new[](const size_t size, const nothrow_t &) noexcept { return Benchmark::allocate(size, 0, true); }
+void *operator new(const size_t size, const align_val_t a) { return Benchmark::allocate(size, static_cast<size_t>(a), false); }
+void *operator new[](const size_t size, const align_val_t a) { return Benchmark::allocate(size, static_cast<size_t>(a), false); }
+void *operator new(const size_t size, const align_val_t a, const nothrow_t &) noexcept {
+  return Benchmark::allocate(size, static_cast<size_t>(a), true);
+}
+void *operator new[](const size_t size, const align_val_t a, const nothrow_t &) noexcept {
+  return Benchmark::allocate(size, static_cast<size_t>(a), true);
+}
+
+void operator delete(void *p) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p) noexcept { Benchmark::deallocate(p); }
+void operator delete(void *p, size_t) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p, size_t) noexcept { Benchmark::deallocate(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { Benchmark::deallocate(p); }
+void operator delete(void *p, align_val_t) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p, align_val_t) noexcept { Benchmark::deallocate(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { Benchmark::deallocate(p); }
+void operator delete(void *p, align_val_t, const nothrow_t &) noexcept { Benchmark::deallocate(p); }
+void operator delete[](void *p, align_val_t, const nothrow_t &) noexcept { Benchmark::deallocate(p); }
+
+namespace Benchmark {
+struct Case {
+  string name;
+  string unit; // what counter counts: "nodes" or "updates"
+  function<double()> run; // returns the quality of the result
+};
+
+struct Report {
+  double milliseconds, quality;
+  size_t count, allocations;
+  long peak_kilobytes;
+};
+
+// runs the case in a child process so that the peak memory belongs to it alone
+inline optional<Report> measure(const Case &c) {
+  int fd[2];
+  if (pipe(fd) != 0) return nullopt;
+  const pid_t pid = fork();
+  if (pid < 0) return nullopt;
+  if (pid == 0) {
+    close(fd[0]);
+    reset_count();
+    allocations = 0;
+    const Timer timer;
+    Report report{};
+    report.quality = c.run();
+    report.milliseconds = static_cast<double>(timer.get_microseconds()) / 1000;
+    report.count = total_count();
+    report.allocations = allocations;
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    report.peak_kilobytes = usage.ru_maxrss;
+    const bool ok = write(fd[1], &report, sizeof(report)) == sizeof(report);
+    close(fd[1]);
+    _exit(ok ? 0 : 1);
+  }
+  close(fd[1]);
+  Report report{};
+  const bool ok = read(fd[0], &report, sizeof(report)) == sizeof(report);
+  close(fd[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (not ok or not WIFEXITED(status) or WEXITSTATUS(status) != 0) return nullopt;
+  return report;
+}
+
+template<template<typename> class Selection = BeamSearch::SegmentTreeSelection,
+  template<typename, typename> class Map = HashMap>
+Case grid_path(const string &variant, const int n, const size_t turns, const size_t width, const size_t capacity = 0) {
+  return {"beam/grid_path/" + variant + "/n=" + to_string(n) + "/T=" + to_string(turns) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const GridPath state(n, 1);
+            const auto path = BeamSearch::euler_tour_beam_search<GridPath, Selection, BeamSearch::NoStatistics, Map>(
+              state, turns, width, capacity);
+            return static_cast<double>(state.score(path));
+          }};
+}
+
+// expansion split over num_threads workers, with the quality of the single-threaded search
+inline Case parallel_grid_path(const size_t num_threads, const int n, const size_t turns, const size_t width) {
+  return {"beam/grid_path/threads=" + to_string(num_threads) + "/n=" + to_string(n) + "/T=" + to_string(turns) + "/W=" +
+          to_string(width),
+          "nodes",
+          [=] {
+            const GridPath state(n, 1);
+            const auto path = BeamSearch::euler_tour_beam_search(state, turns, width, 0, num_threads);
+            return static_cast<double>(state.score(path));
+          }};
+}
+
+// the search of segment_tree with BeamStatistics recorded, which must not change the result
+inline Case grid_path_statistics(const int n, const size_t turns, const size_t width) {
+  return {"beam/grid_path/statistics/n=" + to_string(n) + "/T=" + to_string(turns) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const GridPath state(n, 1);
+            BeamSearch::BeamStatistics statistics;
+            const auto path = BeamSearch::euler_tour_beam_search(state, turns, width, 0, 1, &statistics);
+            return static_cast<double>(state.score(path));
+          }};
+}
+
+// the beam narrows between turns when the budget runs short; the ms column must stay within it
+inline Case time_limited_grid_path(const int n, const size_t turns, const size_t max_width, const int milliseconds) {
+  return {"beam/grid_path/time_limited/n=" + to_string(n) + "/T=" + to_string(turns) + "/ms=" + to_string(milliseconds),
+          "nodes",
+          [=] {
+            const GridPath state(n, 1);
+            const auto path = BeamSearch::time_limited_euler_tour_beam_search(state, turns, milliseconds, max_width);
+            return static_cast<double>(state.score(path));
+          }};
+}
+
+template<int N, ZobristKey Key>
+Case zobrist_grid_path(const size_t width) {
+  return {"beam/zobrist_grid_path/key=" + to_string(8 * sizeof(Key)) + "/N=" + to_string(N) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const GridPath grid(N, 1);
+            const ZobristGridPath<N, Key> state(grid, 2);
+            const auto path = BeamSearch::euler_tour_beam_search(state, 100, width);
+            return static_cast<double>(grid.score(path));
+          }};
+}
+
+// the same search by both engines, to follow where copying states beats replaying the tour
+template<int N>
+Case compact_grid_path(const bool copy, const size_t width) {
+  return {string("beam/compact_grid_path/") + (copy ? "copy" : "euler_tour") + "/N=" + to_string(N) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const GridPath grid(N, 1);
+            const CompactGridPath<N> state(grid);
+            const auto path = copy ? BeamSearch::copy_beam_search(state, 100, width)
+                                   : BeamSearch::euler_tour_beam_search(state, 100, width);
+            return static_cast<double>(grid.score(path));
+          }};
+}
+
+template<size_t Width>
+Case static_grid_path(const int n, const size_t turns) {
+  return {"beam/grid_path/static/n=" + to_string(n) + "/T=" + to_string(turns) + "/W=" + to_string(Width),
+          "nodes",
+          [=] {
+            const GridPath state(n, 1);
+            const auto path = BeamSearch::static_euler_tour_beam_search<Width>(state, turns);
+            return static_cast<double>(state.score(path));
+          }};
+}
+
+inline Case tsp(const int n, const size_t width) {
+  return {"beam/tsp/n=" + to_string(n) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const TSP state(n, 2);
+            const auto path = BeamSearch::euler_tour_beam_search(state, n - 1, width, 2 * width * n + 1);
+            return static_cast<double>(state.length(path));
+          }};
+}
+
+// the first passes run at width 1 with nearly a hundred candidates per turn
+inline Case time_limited_tsp(const int n, const size_t max_width, const int milliseconds) {
+  return {"beam/tsp/time_limited/worst_first/n=" + to_string(n) + "/ms=" + to_string(milliseconds),
+          "nodes",
+          [=] {
+            const TSP state(n, 2, true);
+            const auto path = BeamSearch::time_limited_euler_tour_beam_search(state, n - 1, milliseconds, max_width);
+            return static_cast<double>(state.length(path));
+          }};
+}
+
+template<bool Lazy>
+Case lookahead_tsp(const int n, const size_t width) {
+  return {string("beam/lookahead_tsp/") + (Lazy ? "lazy" : "eager") + "/n=" + to_string(n) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const LookaheadTSP<Lazy> state(n, 2);
+            const auto path = BeamSearch::euler_tour_beam_search(state, n - 1, width, 2 * width * n + 1);
+            return static_cast<double>(state.length(path));
+          }};
+}
+
+inline Case grid_route(const bool optimising, const int n, const size_t width) {
+  return {string("beam/grid_route/") + (optimising ? "optimising" : "first_finished") + "/n=" + to_string(n) + "/W=" + to_string(width),
+          "nodes",
+          [=] {
+            const GridRoute state(n, 5);
+            const size_t max_turn = 2 * n;
+            const auto path = optimising ? BeamSearch::optimising_euler_tour_beam_search(state, max_turn, width)
+                                         : BeamSearch::euler_tour_beam_search(state, max_turn, width);
+            return static_cast<double>(state.cost(path));
+          }};
+}
+
+inline Case minimax(const int branching, const int depth) {
+  return {"minimax/random_game/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            RandomGame state(branching, depth, 3);
+            return static_cast<double>(MiniMax::get_best_score(state, depth));
+          }};
+}
+
+// quality is the chosen root action, which must not depend on the number of threads
+inline Case parallel_minimax(const size_t num_threads, const int branching, const int depth) {
+  return {"minimax/random_game/parallel/threads=" + to_string(num_threads) + "/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            const RandomGame state(branching, depth, 3);
+            return static_cast<double>(MiniMax::parallel_get_best_action(state, depth, num_threads));
+          }};
+}
+
+inline Case alphabeta(const int branching, const int depth) {
+  return {"alphabeta/random_game/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            RandomGame state(branching, depth, 3);
+            using Cost = RandomGame::Cost;
+            return static_cast<double>(AlphaBeta::get_best_score(state, numeric_limits<Cost>::min() + 1,
+                                                                 numeric_limits<Cost>::max(), depth));
+          }};
+}
+
+// the same game searched without and with a transposition table
+inline Case transposition_game(const bool hashed, const int branching, const int depth) {
+  return {string("alphabeta/transposition_game/") + (hashed ? "table" : "plain") + "/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            TranspositionGame state(branching, depth, 3);
+            using Cost = TranspositionGame::Cost;
+            constexpr Cost alpha = numeric_limits<Cost>::min() + 1, beta = numeric_limits<Cost>::max();
+            if (not hashed) {
+              return static_cast<double>(AlphaBeta::get_best_score(state, alpha, beta, depth));
+            }
+            AlphaBeta::TranspositionTable<Cost> table(1 << 20);
+            return static_cast<double>(AlphaBeta::get_best_score(state, alpha, beta, depth, table));
+          }};
+}
+
+// fixed depth, so the root score must match the serial search for every number of threads
+inline Case lazy_smp(const size_t num_threads, const int branching, const int depth) {
+  return {"alphabeta/transposition_game/smp/threads=" + to_string(num_threads) + "/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            TranspositionGame state(branching, depth, 3);
+            AlphaBeta::TranspositionTable<TranspositionGame::Cost> table(1 << 20);
+            return static_cast<double>(AlphaBeta::lazy_smp(state, numeric_limits<int>::max(), depth, num_threads, table).score);
+          }};
+}
+
+inline Case score_game(const bool pvs, const int branching, const int depth) {
+  return {string("alphabeta/score_game/") + (pvs ? "pvs" : "fixed") + "/b=" + to_string(branching) + "/d=" + to_string(depth),
+          "nodes",
+          [=] {
+            ScoreGame state(branching, depth, 3);
+            using Cost = ScoreGame::Cost;
+            constexpr Cost alpha = numeric_limits<Cost>::min() + 1, beta = numeric_limits<Cost>::max();
+            return static_cast<double>(pvs ? AlphaBeta::principal_variation_search(state, alpha, beta, depth)
+                                           : AlphaBeta::get_best_score(state, alpha, beta, depth));
+          }};
+}
+
+// iterative deepening up to depth (quality: root score) or for milliseconds (quality: depth)
+inline Case iterative_deepening(const int branching, const int depth, const int milliseconds, const int aspiration = 0) {
+  const string limit = milliseconds > 0 ? "ms=" + to_string(milliseconds) : "d=" + to_string(depth);
+  return {"alphabeta/score_game/deepening/b=" + to_string(branching) + "/" + limit +
+          (aspiration > 0 ? "/asp=" + to_string(aspiration) : ""),
+          "nodes",
+          [=] {
+            ScoreGame state(branching, milliseconds > 0 ? 1 << 10 : depth, 3);
+            if (milliseconds > 0) {
+              return static_cast<double>(AlphaBeta::iterative_deepening(state, milliseconds, 64, aspiration).depth);
+            }
+            return static_cast<double>(AlphaBeta::iterative_deepening(state, numeric_limits<int>::max(), depth, aspiration).score);
+          }};
+}
+
+// quality is the exact score of the chosen root action, by alpha-beta
+inline Case mcts(const size_t num_threads, const int branching, const int depth, const int milliseconds) {
+  return {"mcts/score_game/threads=" + to_string(num_threads) + "/b=" + to_string(branching) + "/d=" + to_string(depth) +
+          "/ms=" + to_string(milliseconds),
+          "nodes",
+          [=] {
+            ScoreGame state(branching, depth, 3);
+            const auto action = num_threads > 1 ? MCTS::root_parallel_search(state, milliseconds, num_threads)
+                                                : MCTS::MonteCarloTreeSearch<ScoreGame>().search(state, milliseconds);
+            const size_t searched = total_count();
+            using Cost = ScoreGame::Cost;
+            state.apply(action);
+            const Cost score = -AlphaBeta::get_best_score(state, numeric_limits<Cost>::min() + 1, numeric_limits<Cost>::max(), depth - 1);
+            reset_count(searched);
+            return static_cast<double>(score);
+          }};
+}
+
+template<typename Random = XorShift, typename Clock = Timer, typename Schedule>
+inline Case simulated_annealing(const string &name, const Schedule schedule, const int n, const int milliseconds,
+                                const ClockCheck check = 256) {
+  return {"sa/spin_glass/" + name + "/n=" + to_string(n) + "/ms=" + to_string(milliseconds),
+          "updates",
+          [=] {
+            SpinGlassSA state(n, 4);
+            auto s = schedule;
+            SimulatedAnnealing::simulated_annealing<Random, Clock>(state, s, milliseconds, check);
+            return static_cast<double>(state.best);
+          }};
+}
+
+// quality is the energy of the returned replica
+inline Case parallel_tempering(const size_t num_threads, const int n, const int milliseconds) {
+  return {"sa/spin_glass/tempering/threads=" + to_string(num_threads) + "/n=" + to_string(n) + "/ms=" +
+          to_string(milliseconds),
+          "updates",
+          [=] {
+            const SpinGlassSA state(n, 4);
+            return static_cast<double>(
+              SimulatedAnnealing::parallel_tempering(state, 1.0, 100.0, milliseconds, 1 << 14, num_threads).energy);
+          }};
+}
+
+template<typename Clock = Timer>
+inline Case hill_climbing(const string &name, const int n, const int milliseconds, const ClockCheck check) {
+  return {"hc/spin_glass/" + name + "/n=" + to_string(n) + "/ms=" + to_string(milliseconds),
+          "updates",
+          [=] {
+            SpinGlassHC state(n, 4);
+            HillClimbing::hill_climbing<Clock>(state, milliseconds, check);
+            return static_cast<double>(state.best);
+          }};
+}
+
+// quality is the tour length
+template<typename Selection>
+inline Case local_search(const string &name, const size_t num_moves, const int n, const int milliseconds) {
+  return {"ls/tour/" + name + "/moves=" + to_string(num_moves) + "/n=" + to_string(n) + "/ms=" + to_string(milliseconds),
+          "moves",
+          [=] {
+            TourMoves state(n, 1, num_moves);
+            LocalSearch::simulated_annealing(state, SimulatedAnnealing::ExponentialSchedule{1000.0, 10.0}, milliseconds, 256,
+                                             Selection{});
+            return static_cast<double>(state.length);
+          }};
+}
+
+inline vector<Case> cases() {
+  vector<Case> ret;
+  for (const size_t width : {100, 1000, 10000}) {
+    ret.emplace_back(grid_path("segment_tree", 30, 100, width));
+  }
+  ret.emplace_back(grid_path("segment_tree", 50, 300, 1000));
+  ret.emplace_back(grid_path<BeamSearch::HeapSelection>("heap", 30, 100, 10000));
+  ret.emplace_back(grid_path<BeamSearch::NthElementSelection>("nth_element", 30, 100, 10000));
+  ret.emplace_back(static_grid_path<1000>(30, 100));
+  ret.emplace_back(static_grid_path<10000>(30, 100));
+  ret.emplace_back(grid_path<BeamSearch::SegmentTreeSelection, SwissHashMap>("swiss_8w", 30, 100, 10000, 8 * 10000));
+  ret.emplace_back(parallel_grid_path(4, 30, 100, 10000));
+  ret.emplace_back(grid_path_statistics(30, 100, 1000));
+  for (const int milliseconds : {10, 100, 400}) {
+    ret.emplace_back(time_limited_grid_path(30, 200, 20000, milliseconds));
+  }
+  ret.emplace_back(zobrist_grid_path<32, uint64_t>(1000));
+  ret.emplace_back(zobrist_grid_path<32, unsigned __int128>(1000));
+  for (const bool copy : {false, true}) {
+    ret.emplace_back(compact_grid_path<16>(copy, 1000));
+    ret.emplace_back(compact_grid_path<64>(copy, 1000));
+    ret.emplace_back(compact_grid_path<128>(copy, 1000));
+  }
+  for (const size_t width : {100, 1000}) {
+    ret.emplace_back(tsp(100, width));
+  }
+  ret.emplace_back(time_limited_tsp(100, 1000, 100));
+  ret.emplace_back(lookahead_tsp<false>(60, 1000));
+  ret.emplace_back(lookahead_tsp<true>(60, 1000));
+  for (const bool optimising : {false, true}) {
+    ret.emplace_back(grid_route(optimising, 100, 1000));
+  }
+  ret.emplace_back(minimax(8, 7));
+  for (const size_t num_threads : {1, 4}) {
+    ret.emplace_back(parallel_minimax(num_threads, 8, 7));
+  }
+  ret.emplace_back(alphabeta(8, 7));
+  ret.emplace_back(alphabeta(8, 10));
+  for (const bool hashed : {false, true}) {
+    ret.emplace_back(transposition_game(hashed, 8, 10));
+  }
+  for (const size_t num_threads : {1, 4}) {
+    ret.emplace_back(lazy_smp(num_threads, 8, 10));
+  }
+  for (const bool pvs : {false, true}) {
+    ret.emplace_back(score_game(pvs, 8, 8));
+  }
+  ret.emplace_back(iterative_deepening(8, 8, 0));
+  ret.emplace_back(iterative_deepening(8, 11, 0));
+  ret.emplace_back(iterative_deepening(8, 11, 0, 50));
+  ret.emplace_back(iterative_deepening(8, 0, 100));
+  for (const size_t num_threads : {1, 4}) {
+    ret.emplace_back(mcts(num_threads, 8, 8, 100));
+  }
+  ret.emplace_back(simulated_annealing("linear", SimulatedAnnealing::LinearSchedule{100.0, 1.0}, 1 << 16, 1000));
+  for (const int n : {1 << 10, 1 << 16}) {
+    ret.emplace_back(simulated_annealing("exponential", SimulatedAnnealing::ExponentialSchedule{100.0, 1.0}, n, 1000));
+    ret.emplace_back(simulated_annealing<BatchXorShift>("exponential/batch", SimulatedAnnealing::ExponentialSchedule{100.0, 1.0}, n, 1000));
+  }
+  ret.emplace_back(simulated_annealing<XorShift, TscTimer>("exponential/tsc_100us", SimulatedAnnealing::ExponentialSchedule{100.0, 1.0},
+                                                          1 << 10, 1000, ClockCheck::every(100)));
+  ret.emplace_back(simulated_annealing("reheating",
+                                       SimulatedAnnealing::Reheating(SimulatedAnnealing::ExponentialSchedule{100.0, 1.0}, 0.02, 0.3),
+                                       1 << 16, 1000));
+  for (const size_t num_threads : {1, 4}) {
+    ret.emplace_back(parallel_tempering(num_threads, 1 << 16, 1000));
+  }
+  for (const int step : {16, 256, 1 << 20}) {
+    ret.emplace_back(hill_climbing("step=" + to_string(step), 1 << 16, 100, step));
+  }
+  ret.emplace_back(hill_climbing<TscTimer>("tsc_100us", 1 << 16, 100, ClockCheck::every(100)));
+  for (const size_t num_moves : {3, 6}) {
+    ret.emplace_back(local_search<LocalSearch::UniformSelection>("uniform", num_moves, 1000, 300));
+    ret.emplace_back(local_search<LocalSearch::UCBSelection>("ucb", num_moves, 1000, 300));
+  }
+  return ret;
+}
+}
+
+int main(int argc, char *argv[]) {
+  const string filter = argc > 1 ? argv[1] : "";
+  printf("%-52s %10s %14s %10s %10s %14s\n", "case", "ms", "per sec", "peak KiB", "allocs", "quality");
+  for (const auto &c : Benchmark::cases()) {
+    if (c.name.find(filter) == string::npos) continue;
+    const auto report = Benchmark::measure(c);
+    if (not report) {
+      printf("%-52s failed\n", c.name.c_str());
+      continue;
+    }
+    const double per_second = report->milliseconds > 0 ? report->count / report->milliseconds * 1000 : 0;
+    printf("%-52s %10.1f %10.3g %-7s %10ld %10zu %14.0f\n", c.name.c_str(), report->milliseconds,
+           per_second, c.unit.c_str(), report->peak_kilobytes, report->allocations, report->quality);
+    fflush(stdout);
+  }
+}
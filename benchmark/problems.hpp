@@ -0,0 +1,710 @@
+namespace Benchmark {
+// Counts expanded nodes or performed updates of the current run. Every thread counts into its
+// own counter, so the threads of a parallel engine neither race nor share a cache line. The
+// first count of a thread touches a thread_local ExitCount, which adds the count of the thread
+// to exited when the thread ends; the counter itself stays trivial and cheap to reach.
+struct Counter {
+  inline static atomic<size_t> exited = 0;
+  size_t count = 0;
+
+  struct ExitCount {
+    ~ExitCount();
+  };
+
+  Counter &operator++() {
+    if (count++ == 0) register_exit();
+    return *this;
+  }
+
+  [[gnu::noinline]] static void register_exit() {
+    thread_local ExitCount exit_count;
+    (void)exit_count;
+  }
+};
+
+inline thread_local Counter counter;
+
+inline Counter::ExitCount::~ExitCount() {
+  Counter::exited.fetch_add(counter.count, memory_order_relaxed);
+}
+
+// the count of this thread and of the threads that have been joined
+[[nodiscard]] inline size_t total_count() {
+  return Counter::exited.load(memory_order_relaxed) + counter.count;
+}
+
+inline void reset_count(const size_t count = 0) {
+  Counter::exited = 0;
+  counter.count = count;
+}
+
+inline uint64_t mix(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+// walk on an n x n grid and collect coins, each cell pays once
+struct GridPath {
+  using Action = int;
+  using Hash = uint64_t;
+
+  struct Evaluator {
+    using Cost = int;
+    int score;
+
+    [[nodiscard]] Cost evaluate() const {
+      return -score;
+    }
+  };
+
+  static constexpr int dy[4] = {0, 1, 0, -1}, dx[4] = {1, 0, -1, 0};
+
+  explicit GridPath(const int n, const uint64_t seed)
+    : n(n), coin(n * n), zobrist_pos(n * n), zobrist_coin(n * n), taken(n * n) {
+    XorShift rng(seed);
+    for (int i = 0; i < n * n; i++) {
+      coin[i] = static_cast<int>(rng.get(100));
+      zobrist_pos[i] = rng.get();
+      zobrist_coin[i] = rng.get();
+    }
+    taken[0] = 1;
+  }
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return {-1, {0}, zobrist_pos[0]};
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &hash, Push &push) const {
+    ++counter;
+    const int y = pos / n, x = pos % n;
+    for (int d = 0; d < 4; d++) {
+      const int ny = y + dy[d], nx = x + dx[d];
+      if (ny < 0 or nx < 0 or ny >= n or nx >= n) continue;
+      const int next = ny * n + nx;
+      const Hash h = hash ^ zobrist_pos[pos] ^ zobrist_pos[next] ^ (taken[next] ? 0 : zobrist_coin[next]);
+      push(d, Evaluator{eval.score + (taken[next] ? 0 : coin[next])}, h, false);
+    }
+  }
+
+  void apply(const Action &d) {
+    pos += dy[d] * n + dx[d];
+    history.emplace_back(taken[pos]);
+    taken[pos] = 1;
+  }
+
+  void rollback(const Action &d) {
+    taken[pos] = history.back();
+    history.pop_back();
+    pos -= dy[d] * n + dx[d];
+  }
+
+  [[nodiscard]] int score(const vector<Action> &path) const {
+    GridPath g = *this;
+    int sum = 0;
+    for (const auto &d : path) {
+      g.apply(d);
+      sum += g.history.back() ? 0 : coin[g.pos];
+    }
+    return sum;
+  }
+
+  int n, pos = 0;
+  vector<int> coin;
+  vector<uint64_t> zobrist_pos, zobrist_coin;
+  vector<char> taken, history;
+};
+
+// GridPath holding only what changes: the visited cells and the rollback history are bitsets
+// and the coins are shared, so the state is N * N / 8 + MAX_TURN / 8 + 16 bytes
+template<int N, int MAX_TURN = 256>
+struct CompactGridPath {
+  using Action = int;
+  using Hash = uint64_t;
+  using Evaluator = GridPath::Evaluator;
+
+  explicit CompactGridPath(const GridPath &grid) : grid(&grid) {
+    assert(grid.n == N);
+    taken.set(0);
+  }
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return grid->make_initial_node();
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &hash, Push &push) const {
+    ++counter;
+    const int y = pos / N, x = pos % N;
+    for (int d = 0; d < 4; d++) {
+      const int ny = y + GridPath::dy[d], nx = x + GridPath::dx[d];
+      if (ny < 0 or nx < 0 or ny >= N or nx >= N) continue;
+      const int next = ny * N + nx;
+      const Hash h = hash ^ grid->zobrist_pos[pos] ^ grid->zobrist_pos[next] ^ (taken[next] ? 0 : grid->zobrist_coin[next]);
+      push(d, Evaluator{eval.score + (taken[next] ? 0 : grid->coin[next])}, h, false);
+    }
+  }
+
+  void apply(const Action &d) {
+    pos += GridPath::dy[d] * N + GridPath::dx[d];
+    history[depth++] = taken[pos];
+    taken.set(pos);
+  }
+
+  void rollback(const Action &d) {
+    taken[pos] = history[--depth];
+    pos -= GridPath::dy[d] * N + GridPath::dx[d];
+  }
+
+  const GridPath *grid;
+  bitset<N * N> taken;
+  bitset<MAX_TURN> history;
+  int pos = 0, depth = 0;
+};
+
+// CompactGridPath hashed with Zobrist<Key, 2, N * N>: [0][cell] is the position and [1][cell]
+// a coin still on the cell
+template<int N, ZobristKey Key>
+struct ZobristGridPath : CompactGridPath<N> {
+  using Hash = Key;
+  using typename CompactGridPath<N>::Action;
+  using typename CompactGridPath<N>::Evaluator;
+  using CompactGridPath<N>::grid, CompactGridPath<N>::taken, CompactGridPath<N>::pos;
+
+  explicit ZobristGridPath(const GridPath &grid, const uint64_t seed) : CompactGridPath<N>(grid), zobrist(seed) {
+  }
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return {-1, {0}, zobrist.get(0, 0)};
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &hash, Push &push) const {
+    ++counter;
+    const int y = pos / N, x = pos % N;
+    for (int d = 0; d < 4; d++) {
+      const int ny = y + GridPath::dy[d], nx = x + GridPath::dx[d];
+      if (ny < 0 or nx < 0 or ny >= N or nx >= N) continue;
+      const int next = ny * N + nx;
+      const Hash h = hash ^ zobrist.get(0, pos) ^ zobrist.get(0, next) ^ (taken[next] ? 0 : zobrist.get(1, next));
+      push(d, Evaluator{eval.score + (taken[next] ? 0 : grid->coin[next])}, h, false);
+    }
+  }
+
+  Zobrist<Key, 2, N * N> zobrist;
+};
+
+// visit every city once, starting at city 0, minimising the length of the path;
+// run it for n - 1 turns. With worst_first the next cities are pushed from the farthest to
+// the nearest, so a full beam of width 1 takes every push and drops the one before it.
+struct TSP {
+  using Action = int;
+  using Hash = uint64_t;
+
+  struct Evaluator {
+    using Cost = int64_t;
+    int64_t length;
+
+    [[nodiscard]] Cost evaluate() const {
+      return length;
+    }
+  };
+
+  explicit TSP(const int n, const uint64_t seed, const bool worst_first = false)
+      : n(n), worst_first(worst_first), x(n), y(n), zobrist_visited(n), zobrist_last(n), visited(n) {
+    XorShift rng(seed);
+    for (int i = 0; i < n; i++) {
+      x[i] = static_cast<int>(rng.get(10000));
+      y[i] = static_cast<int>(rng.get(10000));
+      zobrist_visited[i] = rng.get();
+      zobrist_last[i] = rng.get();
+    }
+    visited[0] = 1;
+    path.emplace_back(0);
+    if (worst_first) {
+      farthest_first.assign(n, vector<int>(n));
+      for (int i = 0; i < n; i++) {
+        iota(farthest_first[i].begin(), farthest_first[i].end(), 0);
+        ranges::sort(farthest_first[i], greater(), [&](const int j) { return distance(i, j); });
+      }
+    }
+  }
+
+  [[nodiscard]] int64_t distance(const int a, const int b) const {
+    return llround(hypot(x[a] - x[b], y[a] - y[b]));
+  }
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return {0, {0}, zobrist_visited[0] ^ zobrist_last[0]};
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &hash, Push &push) const {
+    ++counter;
+    const int last = path.back();
+    if (worst_first) {
+      for (const int next : farthest_first[last]) {
+        if (visited[next]) continue;
+        const Hash h = hash ^ zobrist_last[last] ^ zobrist_visited[next] ^ zobrist_last[next];
+        push(next, Evaluator{eval.length + distance(last, next)}, h, false);
+      }
+      return;
+    }
+    for (int next = 0; next < n; next++) {
+      if (visited[next]) continue;
+      // the hash keeps the set of visited cities and the current one
+      const Hash h = hash ^ zobrist_last[last] ^ zobrist_visited[next] ^ zobrist_last[next];
+      push(next, Evaluator{eval.length + distance(last, next)}, h, false);
+    }
+  }
+
+  void apply(const Action &next) {
+    visited[next] = 1;
+    path.emplace_back(next);
+  }
+
+  void rollback(const Action &next) {
+    visited[next] = 0;
+    path.pop_back();
+  }
+
+  [[nodiscard]] int64_t length(const vector<Action> &p) const {
+    int64_t sum = 0;
+    int last = 0;
+    for (const auto &next : p) {
+      sum += distance(last, next);
+      last = next;
+    }
+    return sum;
+  }
+
+  int n;
+  bool worst_first;
+  vector<int> x, y;
+  vector<uint64_t> zobrist_visited, zobrist_last;
+  vector<vector<int> > farthest_first;
+  vector<char> visited;
+  vector<int> path;
+};
+
+// cheapest monotone route from the top-left to the bottom-right corner of an n x n grid of
+// weights, stepping right, down or diagonally (twice the weight). The cost is the weight so far
+// plus the Chebyshev distance left, so it never decreases along a route, and routes finish
+// anywhere between turn n - 1 and 2n - 2.
+struct GridRoute {
+  using Action = int;
+  using Hash = uint64_t;
+
+  struct Evaluator {
+    using Cost = int;
+    int weight, left;
+
+    [[nodiscard]] Cost evaluate() const {
+      return weight + left;
+    }
+  };
+
+  static constexpr int dy[3] = {0, 1, 1}, dx[3] = {1, 0, 1};
+
+  explicit GridRoute(const int n, const uint64_t seed) : n(n), weight(n * n), zobrist(n * n) {
+    XorShift rng(seed);
+    for (int i = 0; i < n * n; i++) {
+      weight[i] = 1 + static_cast<int>(rng.get(9));
+      zobrist[i] = rng.get();
+    }
+  }
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return {-1, {0, n - 1}, zobrist[0]};
+  }
+
+  [[nodiscard]] int step(const int next, const int d) const {
+    return d == 2 ? 2 * weight[next] : weight[next];
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &, Push &push) const {
+    ++counter;
+    const int y = pos / n, x = pos % n;
+    for (int d = 0; d < 3; d++) {
+      const int ny = y + dy[d], nx = x + dx[d];
+      if (ny >= n or nx >= n) continue;
+      const int next = ny * n + nx;
+      const int left = n - 1 - min(ny, nx);
+      push(d, Evaluator{eval.weight + step(next, d), left}, zobrist[next], ny == n - 1 and nx == n - 1);
+    }
+  }
+
+  void apply(const Action &d) {
+    pos += dy[d] * n + dx[d];
+  }
+
+  void rollback(const Action &d) {
+    pos -= dy[d] * n + dx[d];
+  }
+
+  [[nodiscard]] int cost(const vector<Action> &path) const {
+    int p = 0, sum = 0;
+    for (const auto &d : path) {
+      p += dy[d] * n + dx[d];
+      sum += step(p, d);
+    }
+    return p == n * n - 1 ? sum : -1;
+  }
+
+  int n, pos = 0;
+  vector<int> weight;
+  vector<uint64_t> zobrist;
+};
+
+// TSP whose evaluator adds the distance from the new city to its nearest unvisited city, an
+// O(n) scan per child. With Lazy, the children push the length so far as a lower bound and the
+// scan runs only for the ones that can still enter the beam.
+template<bool Lazy>
+struct LookaheadTSP : TSP {
+  struct Evaluator {
+    using Cost = int64_t;
+    int64_t length, lookahead;
+
+    [[nodiscard]] Cost evaluate() const {
+      return length + lookahead;
+    }
+  };
+
+  using TSP::TSP;
+
+  [[nodiscard]] tuple<Action, Evaluator, Hash> make_initial_node() const {
+    return {0, {0, 0}, zobrist_visited[0] ^ zobrist_last[0]};
+  }
+
+  [[nodiscard]] int64_t nearest(const int from) const {
+    int64_t ret = 0;
+    for (int c = 0; c < n; c++) {
+      if (visited[c] or c == from) continue;
+      if (const auto d = distance(from, c); ret == 0 or d < ret) ret = d;
+    }
+    return ret;
+  }
+
+  template<typename Push>
+  void expand(const Action &, const Evaluator &eval, const Hash &hash, Push &push) const {
+    ++counter;
+    const int last = path.back();
+    for (int next = 0; next < n; next++) {
+      if (visited[next]) continue;
+      const int64_t length = eval.length + distance(last, next);
+      const Hash h = hash ^ zobrist_last[last] ^ zobrist_visited[next] ^ zobrist_last[next];
+      if constexpr (Lazy) {
+        push(next, length, [&] { return pair{Evaluator{length, nearest(next)}, h}; }, false);
+      } else {
+        push(next, Evaluator{length, nearest(next)}, h, false);
+      }
+    }
+  }
+};
+
+// uniform game tree with pseudo random leaf values, same shape as MiniMaxState
+struct RandomGame {
+  using Action = int;
+  using Cost = int;
+
+  explicit RandomGame(const int branching, const int depth, const uint64_t seed)
+    : branching(branching), depth(depth), hash(seed) {
+  }
+
+  [[nodiscard]] bool is_finished() const {
+    return ply == depth;
+  }
+
+  [[nodiscard]] Cost evaluate() const {
+    return static_cast<int>(mix(hash) % 2001) - 1000;
+  }
+
+  template<typename Push>
+  void expand(Push &push) const {
+    for (int a = 0; a < branching; a++) {
+      push(a);
+    }
+  }
+
+  void apply(const Action &a) {
+    ++counter;
+    history.emplace_back(hash);
+    hash = mix(hash + a + 1);
+    ++ply;
+  }
+
+  void rollback(const Action &) {
+    hash = history.back();
+    history.pop_back();
+    --ply;
+  }
+
+  int branching, depth, ply = 0;
+  uint64_t hash;
+  vector<uint64_t> history;
+};
+
+// RandomGame whose position is the multiset of actions of each player, so every order of the
+// same actions reaches the same position and hash() identifies it
+struct TranspositionGame {
+  using Action = int;
+  using Cost = int;
+
+  explicit TranspositionGame(const int branching, const int depth, const uint64_t seed)
+    : branching(branching), depth(depth), keys(2 * branching), hash_(seed) {
+    XorShift rng(seed);
+    for (auto &key : keys) {
+      key = rng.get();
+    }
+  }
+
+  [[nodiscard]] bool is_finished() const {
+    return ply == depth;
+  }
+
+  [[nodiscard]] Cost evaluate() const {
+    return static_cast<int>(mix(hash_) % 2001) - 1000;
+  }
+
+  template<typename Push>
+  void expand(Push &push) const {
+    for (int a = 0; a < branching; a++) {
+      push(a);
+    }
+  }
+
+  void apply(const Action &a) {
+    ++counter;
+    hash_ += keys[ply % 2 * branching + a];
+    ++ply;
+  }
+
+  void rollback(const Action &a) {
+    --ply;
+    hash_ -= keys[ply % 2 * branching + a];
+  }
+
+  [[nodiscard]] uint64_t hash() const {
+    return hash_;
+  }
+
+  int branching, depth, ply = 0;
+  vector<uint64_t> keys;
+  uint64_t hash_;
+};
+
+// game where every action pays points to the player who takes it, so a shallow search predicts
+// a deeper one and move ordering pays off; actions have a position independent bias
+struct ScoreGame {
+  using Action = int;
+  using Cost = int;
+
+  explicit ScoreGame(const int branching, const int depth, const uint64_t seed)
+    : branching(branching), depth(depth), hash(seed), bias(branching) {
+    XorShift rng(seed);
+    for (auto &b : bias) {
+      b = static_cast<int>(rng.get(101)) - 50;
+    }
+  }
+
+  [[nodiscard]] bool is_finished() const {
+    return ply == depth;
+  }
+
+  // points of the player to move minus points of the other
+  [[nodiscard]] Cost evaluate() const {
+    return score;
+  }
+
+  template<typename Push>
+  void expand(Push &push) const {
+    for (int a = 0; a < branching; a++) {
+      push(a);
+    }
+  }
+
+  void apply(const Action &a) {
+    ++counter;
+    score = -(score + gain(a));
+    history.emplace_back(hash);
+    hash = mix(hash + a + 1);
+    ++ply;
+  }
+
+  void rollback(const Action &a) {
+    hash = history.back();
+    history.pop_back();
+    --ply;
+    score = -score - gain(a);
+  }
+
+  [[nodiscard]] size_t action_id(const Action &a) const {
+    return a;
+  }
+
+  [[nodiscard]] int gain(const Action &a) const {
+    return static_cast<int>(mix(hash + a + 1) % 101) - 50 + bias[a];
+  }
+
+  int branching, depth, ply = 0, score = 0;
+  uint64_t hash;
+  vector<uint64_t> history;
+  vector<int> bias;
+};
+
+// ring of spins with random couplings and fields, maximising -energy
+struct SpinGlass {
+  explicit SpinGlass(const int n, const uint64_t seed) : n(n), spin(n), coupling(n), field(n), rng(seed) {
+    for (int i = 0; i < n; i++) {
+      spin[i] = rng.get(2) ? 1 : -1;
+      coupling[i] = static_cast<int>(rng.get(201)) - 100;
+      field[i] = static_cast<int>(rng.get(21)) - 10;
+    }
+    for (int i = 0; i < n; i++) {
+      energy += coupling[i] * spin[i] * spin[(i + 1) % n] + field[i] * spin[i];
+    }
+    best = energy;
+  }
+
+  [[nodiscard]] int64_t gain(const int i) const {
+    const int l = (i + n - 1) % n, r = (i + 1) % n;
+    return 2 * static_cast<int64_t>(spin[i]) * (coupling[l] * spin[l] + coupling[i] * spin[r] + field[i]);
+  }
+
+  void flip(const int i, const int64_t g) {
+    spin[i] = -spin[i];
+    energy -= g;
+    best = min(best, energy);
+  }
+
+  // for parallel_tempering
+  [[nodiscard]] double score() const {
+    return -static_cast<double>(energy);
+  }
+
+  void seed(const uint64_t s) {
+    rng = XorShift(s);
+  }
+
+  int n;
+  vector<int> spin, coupling, field;
+  XorShift rng;
+  int64_t energy = 0, best = 0;
+};
+
+struct SpinGlassSA : SpinGlass {
+  using SpinGlass::SpinGlass;
+
+  bool update(const double delta, double) {
+    ++counter;
+    const int i = static_cast<int>(rng.get(n));
+    if (const auto g = gain(i); static_cast<double>(g) >= delta) {
+      flip(i, g);
+      return true;
+    }
+    return false;
+  }
+};
+
+struct SpinGlassHC : SpinGlass {
+  using SpinGlass::SpinGlass;
+
+  void update() {
+    ++counter;
+    const int i = static_cast<int>(rng.get(n));
+    if (const auto g = gain(i); g >= 0) {
+      flip(i, g);
+    }
+  }
+};
+
+// tour over n random cities for LocalSearch, with three move types: 2-opt (reverse a segment),
+// swap two cities and or-opt (move one city elsewhere); delta() is the decrease of the length.
+// Types from 3 up to num_moves repeat the swap, a weak move a selection has to learn to avoid.
+struct TourMoves {
+  explicit TourMoves(const int n, const uint64_t seed, const size_t num_moves = 3)
+    : n(n), moves(num_moves), dist(n * n), tour(n), rng(seed) {
+    vector<int> x(n), y(n);
+    for (int i = 0; i < n; i++) {
+      x[i] = static_cast<int>(rng.get(10000));
+      y[i] = static_cast<int>(rng.get(10000));
+      tour[i] = i;
+    }
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        dist[i * n + j] = llround(hypot(x[i] - x[j], y[i] - y[j]));
+      }
+    }
+    for (int i = 0; i < n; i++) {
+      length += d(tour[i], tour[(i + 1) % n]);
+    }
+  }
+
+  [[nodiscard]] size_t num_moves() const {
+    return moves;
+  }
+
+  void propose(const size_t move) {
+    ++counter;
+    type = move < 3 ? move : 1;
+    const auto at = [&](const int k) { return tour[(k + n) % n]; };
+    if (type == 2) {
+      // the city at i goes between j and j + 1
+      i = static_cast<int>(rng.get(n));
+      do {
+        j = static_cast<int>(rng.get(n));
+      } while (j == i or (j + 1) % n == i);
+      gain = d(at(i - 1), at(i)) + d(at(i), at(i + 1)) - d(at(i - 1), at(i + 1)) + d(at(j), at(j + 1)) -
+             d(at(j), at(i)) - d(at(i), at(j + 1));
+      return;
+    }
+    // 0 <= i, i + 2 <= j <= n - 2
+    i = static_cast<int>(rng.get(n - 3));
+    j = static_cast<int>(rng.get(i + 2, n - 1));
+    if (type == 0) {
+      gain = d(at(i), at(i + 1)) + d(at(j), at(j + 1)) - d(at(i), at(j)) - d(at(i + 1), at(j + 1));
+    } else {
+      gain = d(at(i - 1), at(i)) + d(at(i), at(i + 1)) + d(at(j - 1), at(j)) + d(at(j), at(j + 1)) -
+             d(at(i - 1), at(j)) - d(at(j), at(i + 1)) - d(at(j - 1), at(i)) - d(at(i), at(j + 1));
+    }
+  }
+
+  [[nodiscard]] double delta() const {
+    return static_cast<double>(gain);
+  }
+
+  void commit() {
+    if (type == 0) {
+      reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+    } else if (type == 1) {
+      swap(tour[i], tour[j]);
+    } else if (i < j) {
+      rotate(tour.begin() + i, tour.begin() + i + 1, tour.begin() + j + 1);
+    } else {
+      rotate(tour.begin() + j + 1, tour.begin() + i, tour.begin() + i + 1);
+    }
+    length -= gain;
+  }
+
+  void revert() {
+  }
+
+  [[nodiscard]] int64_t d(const int a, const int b) const {
+    return dist[a * n + b];
+  }
+
+  int n;
+  size_t moves;
+  vector<int64_t> dist;
+  vector<int> tour;
+  XorShift rng;
+  int64_t length = 0, gain = 0;
+  size_t type = 0;
+  int i = 0, j = 0;
+};
+}
@@ -1,10 +1,14 @@
-template<class Key, class T>
+template<class Key>
+concept HashKey = integral<Key> or same_as<Key, unsigned __int128>;
+
+template<HashKey Key, class T>
 struct HashMap {
   explicit HashMap(size_t n) : n(n), generation(1), valid(n), data(n) {
   }
 
   [[nodiscard]] pair<bool, int> get_index(Key key) const {
-    Key i = key % n;
+    // the low 64 bits pick the home slot, the whole key is compared
+    size_t i = static_cast<size_t>(key) % n;
     while (valid[i] == generation) {
       if (data[i].first == key) {
         return {true, i};
@@ -25,6 +29,11 @@ struct HashMap {
     return data[i].second;
   }
 
+  [[nodiscard]] size_t distance(Key key, int i) const {
+    // number of slots between the home slot of key and i
+    return (static_cast<size_t>(i) + n - static_cast<size_t>(key) % n) % n;
+  }
+
   void clear() {
     ++generation;
   }
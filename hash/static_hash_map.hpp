@@ -0,0 +1,66 @@
+// HashMap with a compile-time power-of-two capacity: the storage is a std::array and the home
+// slot is the top bits of a multiplicative hash, so a lookup has no division.
+template<HashKey Key, class T, size_t N>
+struct StaticHashMap {
+  static_assert(has_single_bit(N));
+
+  explicit StaticHashMap(const size_t n = N) : generation(1), valid{} {
+    assert(n <= N);
+  }
+
+  [[nodiscard]] pair<bool, int> get_index(Key key) const {
+    size_t i = home(key);
+    while (valid[i] == generation) {
+      if (data[i].first == key) {
+        return {true, static_cast<int>(i)};
+      }
+      i = (i + 1) & MASK;
+    }
+    return {false, static_cast<int>(i)};
+  }
+
+  void set(int i, Key key, T value) {
+    valid[i] = generation;
+    data[i] = {key, value};
+  }
+
+  [[nodiscard]] T get(int i) const {
+    return data[i].second;
+  }
+
+  [[nodiscard]] size_t distance(Key key, int i) const {
+    // number of slots between the home slot of key and i
+    return (static_cast<size_t>(i) - home(key)) & MASK;
+  }
+
+  void clear() {
+    ++generation;
+  }
+
+  private:
+    static constexpr size_t MASK = N - 1;
+    static constexpr int SHIFT = 64 - countr_zero(N);
+
+    uint32_t generation;
+    array<uint32_t, N> valid;
+    array<pair<Key, T>, N> data;
+
+    [[nodiscard]] static size_t home(Key key) {
+      uint64_t x = static_cast<uint64_t>(key);
+      if constexpr (sizeof(Key) > sizeof(uint64_t)) {
+        x ^= static_cast<uint64_t>(key >> 64);
+      }
+      if constexpr (N == 1) {
+        return 0;
+      } else {
+        return (x * 0x9e3779b97f4a7c15ull) >> SHIFT;
+      }
+    }
+};
+
+// binds the capacity, for template template parameters such as the Map of BeamSelector
+template<size_t N>
+struct StaticHashMapOf {
+  template<class Key, class T>
+  using type = StaticHashMap<Key, T, N>;
+};
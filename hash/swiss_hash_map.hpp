@@ -0,0 +1,120 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Open addressing over groups of 16 slots. Each slot has a control byte holding 7 bits of the
+// hash (or EMPTY), so one compare of the group's control bytes finds every candidate slot.
+// The capacity is a power of two, the group is picked by the upper bits of a multiplicative
+// hash and groups are probed triangularly. clear() is O(1): a group written in an older
+// generation counts as empty and is reset on its first write.
+template<HashKey Key, class T>
+struct SwissHashMap {
+  explicit SwissHashMap(size_t n) : generation(1) {
+    const size_t num_groups = bit_ceil(max<size_t>((n + GROUP_SIZE - 1) / GROUP_SIZE, 1));
+    shift = 64 - countr_zero(num_groups);
+    mask = num_groups - 1;
+    groups.resize(num_groups);
+    data.resize(num_groups * GROUP_SIZE);
+  }
+
+  [[nodiscard]] pair<bool, int> get_index(Key key) const {
+    const uint64_t h = hash(key);
+    const uint8_t tag = h2(h);
+    size_t g = h1(h);
+    // slots are filled from the front of a group, so the key is most likely in its first line;
+    // fetch it while the control bytes are loaded instead of after the match
+    __builtin_prefetch(&data[g * GROUP_SIZE]);
+    for (size_t step = 1;; g = (g + step++) & mask) {
+      const auto &group = groups[g];
+      if (group.generation != generation) {
+        return {false, static_cast<int>(g * GROUP_SIZE)};
+      }
+      for (uint32_t m = match(group, tag); m != 0; m &= m - 1) {
+        const size_t i = g * GROUP_SIZE + countr_zero(m);
+        if (data[i].first == key) {
+          return {true, static_cast<int>(i)};
+        }
+      }
+      if (const uint32_t m = match(group, EMPTY); m != 0) {
+        return {false, static_cast<int>(g * GROUP_SIZE + countr_zero(m))};
+      }
+    }
+  }
+
+  void set(int i, Key key, T value) {
+    auto &group = groups[i / GROUP_SIZE];
+    if (group.generation != generation) {
+      group.control.fill(EMPTY);
+      group.generation = generation;
+    }
+    group.control[i % GROUP_SIZE] = h2(hash(key));
+    data[i] = {key, value};
+  }
+
+  [[nodiscard]] T get(int i) const {
+    return data[i].second;
+  }
+
+  [[nodiscard]] size_t distance(Key key, int i) const {
+    // number of slots between the first slot of the home group of key and i
+    return (static_cast<size_t>(i) - h1(hash(key)) * GROUP_SIZE) & (data.size() - 1);
+  }
+
+  void clear() {
+    ++generation;
+  }
+
+  private:
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr uint8_t EMPTY = 0x80;
+
+    // control bytes and generation of a group share one cache line
+    struct alignas(32) Group {
+      array<uint8_t, GROUP_SIZE> control{};
+      uint32_t generation = 0;
+    };
+
+    uint32_t generation;
+    int shift;
+    size_t mask;
+    vector<Group> groups;
+    vector<pair<Key, T> > data;
+
+    [[nodiscard]] static uint64_t hash(Key key) {
+      uint64_t x = static_cast<uint64_t>(key);
+      if constexpr (sizeof(Key) > sizeof(uint64_t)) {
+        x ^= static_cast<uint64_t>(key >> 64);
+      }
+      return x * 0x9e3779b97f4a7c15ull;
+    }
+
+    [[nodiscard]] size_t h1(const uint64_t h) const {
+      return shift == 64 ? 0 : h >> shift;
+    }
+
+    [[nodiscard]] static uint8_t h2(const uint64_t h) {
+      // disjoint from the bits used by h1 up to 2^32 groups
+      return static_cast<uint8_t>(h >> 25 & 0x7f);
+    }
+
+    // bit k is set if control byte k equals tag
+    [[nodiscard]] static uint32_t match(const Group &group, const uint8_t tag) {
+#ifdef __SSE2__
+      const __m128i control = _mm_load_si128(reinterpret_cast<const __m128i *>(group.control.data()));
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+      uint64_t words[2];
+      memcpy(words, group.control.data(), sizeof(words));
+      uint32_t ret = 0;
+      for (int k = 0; k < 2; k++) {
+        // the high bit of each byte of x is set iff the byte is zero; borrows may set it above
+        // a zero byte too, which only adds a spurious candidate that the key compare rejects
+        const uint64_t x = words[k] ^ (0x0101010101010101ull * tag);
+        const uint64_t zero = (x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull;
+        // gather the high bits of the 8 bytes into one byte
+        ret |= static_cast<uint32_t>(((zero >> 7) * 0x0102040810204080ull) >> 56) << (8 * k);
+      }
+      return ret;
+#endif
+    }
+};
@@ -0,0 +1,53 @@
+template<class Key>
+concept ZobristKey = same_as<Key, uint64_t> or same_as<Key, unsigned __int128>;
+
+// random keys for every (i0, i1, ...) in [0, D0) x [0, D1) x ..., and the xor of the applied ones
+template<ZobristKey Key, size_t... Dims>
+struct Zobrist {
+  static_assert(sizeof...(Dims) > 0);
+  static constexpr size_t size = (Dims * ...);
+
+  explicit Zobrist(const uint64_t seed = 88172645463325252ull) : hash(0) {
+    XorShift rng(seed);
+    for (auto &key : table) {
+      key = rng.get();
+      if constexpr (same_as<Key, unsigned __int128>) {
+        key = key << 64 | rng.get();
+      }
+    }
+  }
+
+  template<typename... I> requires (sizeof...(I) == sizeof...(Dims))
+  [[nodiscard]] static constexpr size_t index(const I... i) {
+    size_t ret = 0;
+    ((ret = ret * Dims + static_cast<size_t>(i)), ...);
+    return ret;
+  }
+
+  template<typename... I> requires (sizeof...(I) == sizeof...(Dims))
+  [[nodiscard]] Key get(const I... i) const {
+    return table[index(i...)];
+  }
+
+  [[nodiscard]] Key get() const {
+    return hash;
+  }
+
+  template<typename... I> requires (sizeof...(I) == sizeof...(Dims))
+  void apply(const I... i) {
+    hash ^= get(i...);
+  }
+
+  template<typename... I> requires (sizeof...(I) == sizeof...(Dims))
+  void rollback(const I... i) {
+    hash ^= get(i...);
+  }
+
+  void clear() {
+    hash = 0;
+  }
+
+  private:
+    array<Key, size> table;
+    Key hash;
+};
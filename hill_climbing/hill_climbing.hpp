@@ -4,18 +4,19 @@ concept HCState = requires(State s)
 {
   { s.update() } -> std::same_as<void>;
 };
-template<HCState State>
-void hill_climbing(State &state, const int end_milliseconds, const int step = 256) {
-  const Timer timer;
-  const auto start_time = timer.get_milliseconds();
-  const auto end_time = start_time + end_milliseconds;
-  while (true) {
-    if (const auto now = timer.get_milliseconds(); now >= end_time) {
-      break;
-    }
-    for (int i = 0; i < step; i++) {
+// Clock is Timer or TscTimer; check is a fixed number of updates between clock reads or
+// ClockCheck::every(microseconds)
+template<typename Clock = Timer, HCState State>
+void hill_climbing(State &state, const int end_milliseconds, ClockCheck check = 256) {
+  const Clock timer;
+  const int64_t end_time = int64_t{end_milliseconds} * 1000;
+  for (auto last = timer.get_microseconds(); last < end_time;) {
+    for (int i = 0, n = check.get(); i < n; i++) {
       state.update();
     }
+    const auto now = timer.get_microseconds();
+    check.record(now - last);
+    last = now;
   }
 }
 }
@@ -0,0 +1,246 @@
+namespace LocalSearch {
+// A state with num_moves() types of moves. propose(move) draws a candidate of that type and
+// delta() is its gain (the value is maximised); the engine then either commit()s or revert()s
+// the candidate before the next propose(). propose() may apply the move and revert() undo it,
+// or propose() may only remember it and commit() apply it.
+template<typename State>
+concept MoveState = requires(State s, const State cs, size_t move)
+{
+  { cs.num_moves() } -> convertible_to<size_t>;
+  { s.propose(move) } -> same_as<void>;
+  { cs.delta() } -> convertible_to<double>;
+  { s.commit() } -> same_as<void>;
+  { s.revert() } -> same_as<void>;
+};
+
+struct MoveStatistics {
+  size_t proposed = 0, accepted = 0, improved = 0;
+  double gain = 0; // sum of the deltas of the accepted moves
+};
+
+struct LocalSearchResult {
+  vector<MoveStatistics> moves; // by move type
+  size_t batches = 0;
+
+  void to_csv(ostream &os) const {
+    os << "move,proposed,accepted,improved,acceptance,gain\n";
+    for (size_t i = 0; i < moves.size(); i++) {
+      const auto &m = moves[i];
+      os << i << ',' << m.proposed << ',' << m.accepted << ',' << m.improved << ','
+          << (m.proposed > 0 ? static_cast<double>(m.accepted) / m.proposed : 0.0) << ',' << m.gain << '\n';
+    }
+  }
+};
+
+// Selections pick the type of the next move. record() gets the reward of every move, 1 for an
+// improvement and 0 otherwise, and next_batch(pulls) is called at every clock check with the
+// number of moves until the next one.
+struct UniformSelection {
+  void reset(const size_t num_moves) {
+    n = static_cast<uint32_t>(num_moves);
+  }
+
+  [[nodiscard]] size_t select(XorShift &rng) const {
+    return rng.get(n);
+  }
+
+  void record(size_t, double) {
+  }
+
+  void next_batch(size_t) {
+  }
+
+  private:
+    uint32_t n = 0;
+};
+
+// UCB1 over batches. At every clock check the moves of the next batch are shared out as UCB1
+// would pull them with the mean rewards frozen: move k gets n_k pulls, where
+// mean_k + exploration * sqrt(ln pulls / (pulls_k + n_k)) is the same for every move with
+// n_k > 0, and the moves of the batch are drawn with probabilities n_k / batch. So the choice
+// does not wait for the outcome of the last move. Pulls and rewards are discounted by decay at
+// every clock check, so the shares follow the moves that pay off in the current phase.
+struct UCBSelection {
+  explicit UCBSelection(const double exploration = 0.05, const double decay = 0.99)
+    : exploration(exploration), decay(decay) {
+  }
+
+  void reset(const size_t num_moves) {
+    pulls.assign(num_moves, 0);
+    rewards.assign(num_moves, 0);
+    means.assign(num_moves, 0);
+    shares.assign(num_moves, 1.0 / num_moves);
+    cumulative.resize(num_moves);
+    partial_sum(shares.begin(), shares.end(), cumulative.begin());
+  }
+
+  [[nodiscard]] size_t select(XorShift &rng) const {
+    const double u = rng.probability();
+    size_t k = 0;
+    for (size_t j = 0; j + 1 < cumulative.size(); j++) {
+      k += u >= cumulative[j];
+    }
+    return k;
+  }
+
+  void record(const size_t move, const double reward) {
+    pulls[move] += 1;
+    rewards[move] += reward;
+  }
+
+  void next_batch(const size_t batch) {
+    const size_t n = pulls.size();
+    double total = 0;
+    for (size_t k = 0; k < n; k++) {
+      pulls[k] *= decay;
+      rewards[k] *= decay;
+      total += pulls[k];
+    }
+    if (ranges::find(pulls, 0.0) == pulls.end()) {
+      share_out(log(total + static_cast<double>(batch)), static_cast<double>(batch));
+    }
+    partial_sum(shares.begin(), shares.end(), cumulative.begin());
+  }
+
+  // the probability of each move in the current batch
+  [[nodiscard]] const vector<double> &get_shares() const {
+    return shares;
+  }
+
+  double exploration, decay;
+
+  private:
+    static constexpr int ITERATIONS = 24; // the level to 2^-24 of the initial range
+
+    vector<double> pulls, rewards, means, shares, cumulative;
+
+    void share_out(const double log_total, const double batch) {
+      const size_t n = pulls.size();
+      const double a = exploration * exploration * log_total;
+      for (size_t k = 0; k < n; k++) {
+        means[k] = rewards[k] / pulls[k];
+      }
+      // pulls of move k until its bound falls to level
+      const auto pulls_to = [&](const size_t k, const double level) {
+        const double gap = level - means[k];
+        return gap > 0 ? max(0.0, a / (gap * gap) - pulls[k]) : numeric_limits<double>::infinity();
+      };
+      const size_t best = ranges::max_element(means) - means.begin();
+      double low = means[best], high = 0;
+      for (size_t k = 0; k < n; k++) {
+        high = max(high, means[k] + sqrt(a / pulls[k]));
+      }
+      // the batch lowers the highest bounds to a common level in (low, high]
+      for (int iteration = 0; iteration < ITERATIONS and a > 0; iteration++) {
+        const double level = (low + high) / 2;
+        double sum = 0;
+        for (size_t k = 0; k < n; k++) {
+          sum += pulls_to(k, level);
+        }
+        (sum > batch ? low : high) = level;
+      }
+      double sum = 0;
+      for (size_t k = 0; k < n; k++) {
+        shares[k] = a > 0 ? pulls_to(k, high) : 0;
+        sum += shares[k];
+      }
+      if (sum == 0) {
+        // without exploration the best mean takes the batch
+        ranges::fill(shares, 0.0);
+        shares[best] = sum = 1;
+      }
+      for (auto &x : shares) {
+        x /= sum;
+      }
+    }
+};
+
+// one move of a type chosen by selection, accepted when delta() >= threshold
+template<MoveState State, typename Selection>
+bool try_move(State &state, Selection &selection, XorShift &rng, LocalSearchResult &result, const double threshold) {
+  const size_t move = selection.select(rng);
+  state.propose(move);
+  const double delta = state.delta();
+  auto &m = result.moves[move];
+  m.proposed++;
+  const bool accepted = delta >= threshold, improved = delta > 0;
+  if (accepted) {
+    state.commit();
+    m.accepted++;
+    m.improved += improved;
+    m.gain += delta;
+  } else {
+    state.revert();
+  }
+  selection.record(move, improved);
+  return accepted;
+}
+
+// SimulatedAnnealing::simulated_annealing over move types: the temperature follows schedule as
+// there, and a move is accepted when delta() >= temp * log(u)
+template<typename Clock = Timer, MoveState State, SimulatedAnnealing::SASchedule Schedule, typename Selection = UniformSelection>
+LocalSearchResult simulated_annealing(State &state,
+                                      Schedule &schedule,
+                                      const int end_milliseconds,
+                                      ClockCheck check,
+                                      Selection selection = Selection()) {
+  constexpr bool OBSERVED = requires(double p, size_t n) { schedule.observe(p, n, n); };
+  const Clock timer;
+  XorShift rng;
+  LocalSearchResult result;
+  result.moves.resize(state.num_moves());
+  selection.reset(state.num_moves());
+  const double end_time = end_milliseconds * 1000.0;
+  double rate = 0; // progress per update in the last batch
+  for (auto now = timer.get_microseconds(); now < end_time; result.batches++) {
+    const int step = check.get();
+    const double progress = now / end_time, next = min(1.0, progress + rate * step);
+    double temp = schedule(progress);
+    const double stride = Schedule::stride(temp, schedule(next), step);
+    size_t accepted = 0;
+    for (int i = 0; i < step; i++) {
+      accepted += try_move(state, selection, rng, result, temp * log(rng.probability()));
+      temp = Schedule::advance(temp, stride);
+    }
+    if constexpr (OBSERVED) {
+      schedule.observe(progress, accepted, step);
+    }
+    const auto previous = now;
+    now = timer.get_microseconds();
+    check.record(now - previous);
+    selection.next_batch(check.get());
+    rate = (now / end_time - progress) / step;
+  }
+  return result;
+}
+
+template<typename Clock = Timer, MoveState State, SimulatedAnnealing::SASchedule Schedule, typename Selection = UniformSelection>
+LocalSearchResult simulated_annealing(State &state,
+                                      Schedule &&schedule,
+                                      const int end_milliseconds,
+                                      const ClockCheck check,
+                                      Selection selection = Selection()) {
+  return simulated_annealing<Clock>(state, schedule, end_milliseconds, check, move(selection));
+}
+
+// HillClimbing::hill_climbing over move types: a move is accepted when delta() >= 0
+template<typename Clock = Timer, MoveState State, typename Selection = UniformSelection>
+LocalSearchResult hill_climbing(State &state, const int end_milliseconds, ClockCheck check = 256, Selection selection = Selection()) {
+  const Clock timer;
+  XorShift rng;
+  LocalSearchResult result;
+  result.moves.resize(state.num_moves());
+  selection.reset(state.num_moves());
+  const int64_t end_time = int64_t{end_milliseconds} * 1000;
+  for (auto last = timer.get_microseconds(); last < end_time; result.batches++) {
+    for (int i = 0, n = check.get(); i < n; i++) {
+      try_move(state, selection, rng, result, 0.0);
+    }
+    const auto now = timer.get_microseconds();
+    check.record(now - last);
+    selection.next_batch(check.get());
+    last = now;
+  }
+  return result;
+}
+}
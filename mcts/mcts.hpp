@@ -0,0 +1,261 @@
+namespace MCTS {
+// the state of MiniMax: evaluate() scores the position for the player to move, and its sign is
+// taken as a win (> 0), draw (== 0) or loss (< 0) at the end of a rollout
+template<class State>
+concept MCTSState =
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             function<void(const typename State::Action &)> push)
+{
+  typename State::Action;
+  typename State::Cost;
+
+  { cs.expand(push) } -> same_as<void>;
+  { cs.is_finished() } -> same_as<bool>;
+  { cs.evaluate() } -> same_as<typename State::Cost>;
+  { s.apply(a) } -> same_as<void>;
+  { s.rollback(a) } -> same_as<void>;
+} &&
+totally_ordered<typename State::Cost>;
+
+template<class State>
+struct MCTSPush {
+  void operator()(const typename State::Action &) const {
+  }
+};
+
+template<class State>
+concept InlineMCTSState =
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             MCTSPush<State> &push)
+{
+  typename State::Action;
+  typename State::Cost;
+
+  { cs.expand(push) } -> same_as<void>;
+  { cs.is_finished() } -> same_as<bool>;
+  { cs.evaluate() } -> same_as<typename State::Cost>;
+  { s.apply(a) } -> same_as<void>;
+  { s.rollback(a) } -> same_as<void>;
+} &&
+totally_ordered<typename State::Cost>;
+
+// UCT. Nodes live in one pool and refer to each other by index: the children of a node are
+// expanded together and are contiguous, pool[first_child, first_child + num_children). The
+// root is pool[0]. advance() keeps the subtree of the played action for the next search.
+template<typename State> requires MCTSState<State> or InlineMCTSState<State>
+struct MonteCarloTreeSearch {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+
+  struct Node {
+    Action action;
+    int first_child = -1; // -1 until expanded
+    int num_children = 0;
+    uint32_t visits = 0;
+    double reward = 0; // sum over playouts, for the player who played action
+  };
+
+  explicit MonteCarloTreeSearch(const double exploration = sqrt(2.0),
+                                const size_t max_rollout_depth = numeric_limits<size_t>::max(),
+                                const size_t max_nodes = 1 << 22,
+                                const uint64_t seed = 88172645463325252ull)
+    : exploration(exploration), max_rollout_depth(max_rollout_depth), max_nodes(max_nodes), rng(seed) {
+    pool.emplace_back();
+  }
+
+  // playouts from state until end_milliseconds have passed, then the most visited action;
+  // the state is restored by rollback
+  Action search(State &state, const int64_t end_milliseconds) {
+    assert(not state.is_finished());
+    const Timer timer;
+    do {
+      playout(state);
+    } while (timer.get_milliseconds() < end_milliseconds);
+    return best_action();
+  }
+
+  void playout(State &state) {
+    path.clear();
+    int v = 0;
+    while (not state.is_finished()) {
+      if (pool[v].first_child < 0) {
+        if (pool.size() >= max_nodes or not expand(state, v)) {
+          break;
+        }
+        v = pool[v].first_child;
+        state.apply(pool[v].action);
+        path.emplace_back(v);
+        break;
+      }
+      v = select(v);
+      state.apply(pool[v].action);
+      path.emplace_back(v);
+    }
+    // reward of the player to move at the end of the path
+    double reward = rollout(state);
+    pool[0].visits++;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      auto &node = pool[*it];
+      reward = 1 - reward;
+      node.visits++;
+      node.reward += reward;
+      state.rollback(node.action);
+    }
+  }
+
+  [[nodiscard]] Action best_action() const {
+    const auto &root = pool[0];
+    assert(root.num_children > 0);
+    int best = root.first_child;
+    for (int c = root.first_child; c < root.first_child + root.num_children; c++) {
+      if (pool[c].visits > pool[best].visits) {
+        best = c;
+      }
+    }
+    return pool[best].action;
+  }
+
+  // the root moves to the child reached by action, keeping its subtree; the rest of the tree
+  // is dropped. Call it for every action applied to the searched state, by either player.
+  void advance(const Action &action) requires equality_comparable<Action> {
+    const auto &root = pool[0];
+    int next = -1;
+    for (int c = root.first_child; c >= 0 and c < root.first_child + root.num_children; c++) {
+      if (pool[c].action == action) {
+        next = c;
+        break;
+      }
+    }
+    spare.clear();
+    if (next < 0) {
+      spare.emplace_back();
+    } else {
+      // copy the subtree breadth first, so that siblings stay contiguous
+      spare.emplace_back(pool[next]);
+      for (size_t i = 0; i < spare.size(); i++) {
+        const int first = spare[i].first_child;
+        if (first < 0) {
+          continue;
+        }
+        spare[i].first_child = static_cast<int>(spare.size());
+        spare.insert(spare.end(), pool.begin() + first, pool.begin() + first + spare[i].num_children);
+      }
+    }
+    pool.swap(spare);
+  }
+
+  [[nodiscard]] const vector<Node> &nodes() const {
+    return pool;
+  }
+
+  private:
+    double exploration;
+    size_t max_rollout_depth, max_nodes;
+    XorShift rng;
+    vector<Node> pool, spare;
+    vector<int> path;
+    vector<Action> candidates, played;
+
+    // appends the children of v, false if the state has no action
+    bool expand(const State &state, const int v) {
+      const int first = static_cast<int>(pool.size());
+      const auto push = [&](const Action &a) { pool.push_back({a}); };
+      state.expand(push);
+      const int n = static_cast<int>(pool.size()) - first;
+      if (n == 0) {
+        return false;
+      }
+      pool[v].first_child = first;
+      pool[v].num_children = n;
+      return true;
+    }
+
+    // the first unvisited child, else the child of the highest upper confidence bound
+    [[nodiscard]] int select(const int v) const {
+      const auto &node = pool[v];
+      const double log_visits = log(static_cast<double>(node.visits));
+      int best = node.first_child;
+      double best_bound = -numeric_limits<double>::infinity();
+      for (int c = node.first_child; c < node.first_child + node.num_children; c++) {
+        const auto &child = pool[c];
+        if (child.visits == 0) {
+          return c;
+        }
+        const double bound = child.reward / child.visits + exploration * sqrt(log_visits / child.visits);
+        if (bound > best_bound) {
+          best_bound = bound;
+          best = c;
+        }
+      }
+      return best;
+    }
+
+    // uniformly random actions until the end or max_rollout_depth; 1, 0.5 or 0 for the player
+    // to move at the start
+    double rollout(State &state) {
+      played.clear();
+      while (played.size() < max_rollout_depth and not state.is_finished()) {
+        candidates.clear();
+        const auto push = [&](const Action &a) { candidates.emplace_back(a); };
+        state.expand(push);
+        if (candidates.empty()) {
+          break;
+        }
+        played.emplace_back(candidates[rng.get(static_cast<uint32_t>(candidates.size()))]);
+        state.apply(played.back());
+      }
+      const Cost score = state.evaluate();
+      double reward = score > Cost{} ? 1 : score < Cost{} ? 0 : 0.5;
+      if (played.size() % 2 == 1) {
+        reward = 1 - reward;
+      }
+      for (auto it = played.rbegin(); it != played.rend(); ++it) {
+        state.rollback(*it);
+      }
+      return reward;
+    }
+};
+
+// root parallelisation: every thread grows its own tree from a copy of the state with its own
+// seed, and the action with the most visits summed over the trees wins
+template<typename State> requires (MCTSState<State> or InlineMCTSState<State>) and copyable<State>
+typename State::Action root_parallel_search(const State &state,
+                                            const int64_t end_milliseconds,
+                                            const size_t num_threads,
+                                            const double exploration = sqrt(2.0),
+                                            const size_t max_rollout_depth = numeric_limits<size_t>::max(),
+                                            const size_t max_nodes = 1 << 22) {
+  using Action = typename State::Action;
+  vector<MonteCarloTreeSearch<State> > trees;
+  for (size_t t = 0; t < num_threads; t++) {
+    trees.emplace_back(exploration, max_rollout_depth, max_nodes, 88172645463325252ull + 0x9e3779b97f4a7c15ull * t);
+  }
+  vector<thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      State copy = state;
+      trees[t].search(copy, end_milliseconds);
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  // the children of every root are the actions in expand order
+  const auto &root = trees[0].nodes()[0];
+  vector<uint64_t> visits(root.num_children);
+  for (const auto &tree : trees) {
+    const auto &pool = tree.nodes();
+    assert(pool[0].num_children == root.num_children);
+    for (int k = 0; k < root.num_children; k++) {
+      visits[k] += pool[pool[0].first_child + k].visits;
+    }
+  }
+  const auto best = ranges::max_element(visits) - visits.begin();
+  const Action action = trees[0].nodes()[root.first_child + best].action;
+  return action;
+}
+}
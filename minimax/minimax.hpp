@@ -17,8 +17,33 @@ concept MiniMaxState =
 } &&
 totally_ordered<typename State::Cost>;
 
-template<MiniMaxState State>
-typename State::Cost get_best_score(State &state, const size_t depth) {
+template<class State>
+struct MiniMaxPush {
+  void operator()(const typename State::Action &) const {
+  }
+};
+
+template<class State>
+concept InlineMiniMaxState =
+    requires(State &s,
+             const State &cs,
+             typename State::Action &a,
+             MiniMaxPush<State> &push)
+{
+  typename State::Action;
+  typename State::Cost;
+
+  { cs.expand(push) } -> same_as<void>;
+  { cs.is_finished() } -> same_as<bool>;
+  { cs.evaluate() } -> same_as<typename State::Cost>;
+  { s.apply(a) } -> same_as<void>;
+  { s.rollback(a) } -> same_as<void>;
+} &&
+totally_ordered<typename State::Cost>;
+
+// The candidates of all plies share stack, see MoveStack.
+template<typename State> requires MiniMaxState<State> or InlineMiniMaxState<State>
+typename State::Cost get_best_score(State &state, const size_t depth, MoveStack<typename State::Action> &stack) {
   using Action = typename State::Action;
   using Cost = typename State::Cost;
 
@@ -26,44 +51,106 @@ typename State::Cost get_best_score(State &state, const size_t depth) {
     return state.evaluate();
   }
 
-  vector<Action> candidates;
-  state.expand([&](const Action &a) { candidates.emplace_back(a); });
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
 
-  if (candidates.empty()) {
+  if (n == 0) {
     return state.evaluate();
   }
 
   Cost best_score = numeric_limits<Cost>::min();
-  for (const auto &action : candidates) {
+  for (size_t i = 0; i < n; i++) {
+    // a copy, the frame moves if a child grows the stack
+    const Action action = stack.frame(first)[i];
     state.apply(action);
-    Cost score = -get_best_score(state, depth - 1);
+    Cost score = -get_best_score(state, depth - 1, stack);
     if (score > best_score) {
       best_score = score;
     }
     state.rollback(action);
   }
+  stack.pop(first);
   return best_score;
 }
 
-template<MiniMaxState State>
-typename State::Action get_best_action(State &state, const size_t depth) {
+template<typename State> requires MiniMaxState<State> or InlineMiniMaxState<State>
+typename State::Cost get_best_score(State &state, const size_t depth) {
+  MoveStack<typename State::Action> stack;
+  return get_best_score(state, depth, stack);
+}
+
+template<typename State> requires MiniMaxState<State> or InlineMiniMaxState<State>
+typename State::Action get_best_action(State &state, const size_t depth, MoveStack<typename State::Action> &stack) {
   using Action = typename State::Action;
   using Cost = typename State::Cost;
   assert(depth > 0 and not state.is_finished());
-  vector<Action> candidates;
-  state.expand([&](const Action &a) { candidates.emplace_back(a); });
-  assert(not candidates.empty());
+  const size_t first = stack.size();
+  const auto push = [&](const Action &a) { stack.push(a); };
+  state.expand(push);
+  const size_t n = stack.size() - first;
+  assert(n > 0);
   Cost best_score = -numeric_limits<Cost>::max();
-  Action best_action;
-  for (const auto &action : candidates) {
+  Action best_action = stack.frame(first)[0];
+  for (size_t i = 0; i < n; i++) {
+    const Action action = stack.frame(first)[i];
     state.apply(action);
-    Cost score = -get_best_score(state, depth - 1);
+    Cost score = -get_best_score(state, depth - 1, stack);
     if (score > best_score) {
       best_score = score;
       best_action = action;
     }
     state.rollback(action);
   }
+  stack.pop(first);
+  return best_action;
+}
+
+template<typename State> requires MiniMaxState<State> or InlineMiniMaxState<State>
+typename State::Action get_best_action(State &state, const size_t depth) {
+  MoveStack<typename State::Action> stack;
+  return get_best_action(state, depth, stack);
+}
+
+// splits the root: threads take root actions in turn and search them on their own copy of the
+// state. Every root action is searched in full, so the result is the one of get_best_action.
+template<typename State> requires (MiniMaxState<State> or InlineMiniMaxState<State>) and copyable<State>
+typename State::Action parallel_get_best_action(const State &state, const size_t depth, const size_t num_threads) {
+  using Action = typename State::Action;
+  using Cost = typename State::Cost;
+  assert(depth > 0 and not state.is_finished());
+  vector<Action> candidates;
+  const auto push = [&](const Action &a) { candidates.emplace_back(a); };
+  state.expand(push);
+  assert(not candidates.empty());
+  vector<Cost> scores(candidates.size());
+  atomic<size_t> next = 0;
+  const auto work = [&] {
+    State copy = state;
+    MoveStack<Action> stack;
+    for (size_t i; (i = next++) < candidates.size();) {
+      copy.apply(candidates[i]);
+      scores[i] = -get_best_score(copy, depth - 1, stack);
+      copy.rollback(candidates[i]);
+    }
+  };
+  vector<thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &th : threads) {
+    th.join();
+  }
+  Cost best_score = -numeric_limits<Cost>::max();
+  Action best_action = candidates[0];
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (scores[i] > best_score) {
+      best_score = scores[i];
+      best_action = candidates[i];
+    }
+  }
   return best_action;
 }
 }
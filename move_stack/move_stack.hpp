@@ -0,0 +1,39 @@
+// Candidates of every ply of a depth-first search in one buffer. A node remembers size(), pushes
+// its actions on top, reads them as frame(first) and pops them before returning, so the buffer
+// only grows past its largest depth x branching and never allocates after that. Reserve that
+// product up front to never allocate at all.
+// A frame is invalidated by a push that grows the buffer: take it again after searching a child.
+template<class Action>
+struct MoveStack {
+  explicit MoveStack(const size_t capacity = 0) : top(0) {
+    buffer.reserve(capacity);
+  }
+
+  [[nodiscard]] size_t size() const {
+    return top;
+  }
+
+  void push(const Action &a) {
+    if (top == buffer.size()) {
+      buffer.emplace_back(a);
+    } else {
+      buffer[top] = a;
+    }
+    ++top;
+  }
+
+  // the actions pushed since size() was first
+  [[nodiscard]] span<const Action> frame(const size_t first) const {
+    assert(first <= top);
+    return {buffer.data() + first, top - first};
+  }
+
+  void pop(const size_t first) {
+    assert(first <= top);
+    top = first;
+  }
+
+  private:
+    size_t top;
+    vector<Action> buffer;
+};
@@ -0,0 +1,70 @@
+// log(x) for normal x > 0: x = m 2^e with m in [2/3, 4/3), and log(m) is a polynomial of
+// degree 6 in m - 1. The absolute error is below 2.5e-6 on [2^-23, 1] and 1e-5 on (0, 1]
+// (exhaustive over the floats).
+[[nodiscard]] inline float fast_log(const float x) {
+  const int32_t bits = bit_cast<int32_t>(x);
+  const int32_t e = (bits - 0x3f2aaaab) >> 23;
+  const float f = bit_cast<float>(bits - (e << 23)) - 1.0f;
+  float p = -0.197134754f;
+  p = p * f + 0.231222128f;
+  p = p * f - 0.247940941f;
+  p = p * f + 0.331531455f;
+  p = p * f - 0.500038938f;
+  p = p * f + 1.00002551f;
+  return f * p + static_cast<float>(e) * 0.693147181f;
+}
+
+// LANES xorshift32 generators stepped together, so that filling a buffer vectorises. Each lane
+// is seeded by splitmix64 of the seed.
+struct BatchXorShift {
+  static constexpr size_t LANES = 16;
+
+  explicit BatchXorShift(uint64_t seed = 88172645463325252ull) {
+    for (auto &x : lanes) {
+      seed += 0x9e3779b97f4a7c15ull;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      x = static_cast<uint32_t>(z ^ (z >> 31)) | 1;
+    }
+  }
+
+  // (0.0, 1.0] in steps of 2^-23
+  void probability(const span<float> out) {
+    fill(out, [](const float u) { return u; });
+  }
+
+  // fast_log(probability()), in [-15.95, 0]
+  void log_probability(const span<float> out) {
+    fill(out, [](const float u) { return fast_log(u); });
+  }
+
+  private:
+    array<uint32_t, LANES> lanes;
+
+    template<typename F>
+    void fill(const span<float> out, const F &f) {
+      size_t i = 0;
+      for (; i + LANES <= out.size(); i += LANES) {
+        block(out.data() + i, f);
+      }
+      if (i < out.size()) {
+        array<float, LANES> rest;
+        block(rest.data(), f);
+        ranges::copy_n(rest.begin(), static_cast<ptrdiff_t>(out.size() - i), out.begin() + i);
+      }
+    }
+
+    template<typename F>
+    void block(float *out, const F &f) {
+      for (size_t l = 0; l < LANES; l++) {
+        uint32_t x = lanes[l];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        lanes[l] = x;
+        // 2 - [1, 2)
+        out[l] = f(2.0f - bit_cast<float>(x >> 9 | 0x3f800000u));
+      }
+    }
+};
@@ -0,0 +1,57 @@
+// SegmentTree over a compile-time number of elements: the tree lives in a std::array and its
+// size is a constant, so the walks have a fixed trip count.
+template<typename Monoid, int N>
+struct StaticSegmentTree {
+  using S = typename Monoid::S;
+
+  static constexpr int sz = bit_ceil(static_cast<unsigned>(max(N, 1)));
+
+  private:
+    array<S, 2 * sz> seg;
+
+    Monoid m;
+
+  public:
+    explicit StaticSegmentTree(Monoid m = Monoid()) : m(m) {
+      seg.fill(m.e());
+    }
+
+    void build(const array<S, N> &v) {
+      for (int k = 0; k < N; k++) seg[k + sz] = v[k];
+      for (int k = sz - 1; k > 0; k--) {
+        seg[k] = m.op(seg[2 * k + 0], seg[2 * k + 1]);
+      }
+    }
+
+    void set(int k, const S &x) {
+      k += sz;
+      seg[k] = x;
+      while (k >>= 1) {
+        seg[k] = m.op(seg[2 * k + 0], seg[2 * k + 1]);
+      }
+    }
+
+    [[nodiscard]] S get(const int k) const { return seg[k + sz]; }
+
+    S operator[](const int k) const { return get(k); }
+
+    void apply(int k, const S &x) {
+      k += sz;
+      seg[k] = m.op(seg[k], x);
+      while (k >>= 1) {
+        seg[k] = m.op(seg[2 * k + 0], seg[2 * k + 1]);
+      }
+    }
+
+    [[nodiscard]] S prod(int l, int r) const {
+      if (l >= r) return m.e();
+      S L = m.e(), R = m.e();
+      for (l += sz, r += sz; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) L = m.op(L, seg[l++]);
+        if (r & 1) R = m.op(seg[--r], R);
+      }
+      return m.op(L, R);
+    }
+
+    [[nodiscard]] S all_prod() const { return seg[1]; }
+};
@@ -0,0 +1,94 @@
+namespace SimulatedAnnealing {
+// score() is the value update() maximises: a move of gain g is accepted when g >= delta
+template<typename State>
+concept PTState = SAState<State> and copyable<State> and requires(const State &cs)
+{
+  { cs.score() } -> convertible_to<double>;
+};
+
+// Replica exchange. num_threads copies of state run on their own threads, the k-th coldest at
+// min_temp * (max_temp / min_temp)^(k / (num_threads - 1)). After every step updates the threads
+// meet, and the replicas of neighbouring temperatures swap with probability
+// min(1, exp((S_hot - S_cold) (1 / T_cold - 1 / T_hot))), even and odd pairs in turn. Every
+// thread has its own XorShift, and a state with seed(uint64_t) is reseeded per replica.
+// Returns a copy of the replica of the highest score seen at a meeting. A single replica has
+// no one to swap with, so it is annealed from max_temp to min_temp by simulated_annealing.
+template<PTState State>
+State parallel_tempering(const State &state,
+                         const double min_temp,
+                         const double max_temp,
+                         const int end_milliseconds,
+                         const int step,
+                         const size_t num_threads) {
+  assert(num_threads > 0 and 0 < min_temp and min_temp <= max_temp);
+  const auto seed = [](const size_t i) { return 88172645463325252ull + 0x9e3779b97f4a7c15ull * i; };
+  if (num_threads == 1) {
+    State replica = state;
+    if constexpr (requires(State &s) { s.seed(uint64_t{}); }) {
+      replica.seed(seed(1));
+    }
+    simulated_annealing(replica, max_temp, min_temp, end_milliseconds, step);
+    return replica.score() >= state.score() ? replica : state;
+  }
+  const Timer timer;
+  vector<State> replicas(num_threads, state);
+  vector<double> temps(num_threads), temp_of(num_threads); // temperature of the k-th coldest, of replica t
+  vector<size_t> replica_of(num_threads); // replica of the k-th coldest
+  for (size_t k = 0; k < num_threads; k++) {
+    temps[k] = min_temp * pow(max_temp / min_temp, static_cast<double>(k) / (num_threads - 1));
+    temp_of[k] = temps[k];
+    replica_of[k] = k;
+    if constexpr (requires(State &s) { s.seed(uint64_t{}); }) {
+      replicas[k].seed(seed(num_threads + k));
+    }
+  }
+
+  State best = state;
+  double best_score = state.score();
+  double progress = 0;
+  bool finished = false;
+  size_t round = 0;
+  XorShift rng(seed(2 * num_threads));
+  // runs on one thread while the others wait, so it owns every replica
+  const auto meet = [&]() noexcept {
+    for (size_t t = 0; t < num_threads; t++) {
+      if (const double s = replicas[t].score(); s > best_score) {
+        best_score = s;
+        best = replicas[t];
+      }
+    }
+    for (size_t k = round++ % 2; k + 1 < num_threads; k += 2) {
+      const size_t cold = replica_of[k], hot = replica_of[k + 1];
+      const double x = (replicas[hot].score() - replicas[cold].score()) * (1 / temps[k] - 1 / temps[k + 1]);
+      if (x >= 0 or rng.probability() < exp(x)) {
+        swap(replica_of[k], replica_of[k + 1]);
+        temp_of[hot] = temps[k];
+        temp_of[cold] = temps[k + 1];
+      }
+    }
+    const auto now = timer.get_milliseconds();
+    finished = now >= end_milliseconds;
+    progress = min(1.0, static_cast<double>(now) / end_milliseconds);
+  };
+  barrier sync(static_cast<ptrdiff_t>(num_threads), meet);
+  const auto run = [&](const size_t t) {
+    XorShift local(seed(t));
+    while (not finished) {
+      const double temp = temp_of[t];
+      for (int i = 0; i < step; i++) {
+        replicas[t].update(temp * log(local.probability()), progress);
+      }
+      sync.arrive_and_wait();
+    }
+  };
+  vector<thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(run, t);
+  }
+  run(0);
+  for (auto &th : threads) {
+    th.join();
+  }
+  return best;
+}
+}
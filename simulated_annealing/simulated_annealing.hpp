@@ -1,29 +1,165 @@
 namespace SimulatedAnnealing {
+// update() may return whether the move was accepted, which schedules that observe the acceptance
+// rate require
 template<typename State>
-concept SAState = requires(State s, double delta, double progress)
+concept AcceptingSAState = requires(State s, double delta, double progress)
+{
+  { s.update(delta, progress) } -> std::same_as<bool>;
+};
+
+template<typename State>
+concept SAState = AcceptingSAState<State> or requires(State s, double delta, double progress)
 {
   { s.update(delta, progress) } -> std::same_as<void>;
 };
+
+// A schedule gives the temperature at a progress in [0, 1]. Between two clock checks the
+// temperature moves from t0 to t1 in n updates by temp = advance(temp, stride(t0, t1, n)).
+template<typename Schedule>
+concept SASchedule = requires(const Schedule cs, double progress, double temp, int n)
+{
+  { cs(progress) } -> convertible_to<double>;
+  { Schedule::stride(temp, temp, n) } -> convertible_to<double>;
+  { Schedule::advance(temp, temp) } -> convertible_to<double>;
+};
+
+struct LinearSchedule {
+  double start_temp, end_temp;
+
+  [[nodiscard]] double operator()(const double progress) const {
+    return start_temp + (end_temp - start_temp) * progress;
+  }
+
+  [[nodiscard]] static double stride(const double t0, const double t1, const int n) {
+    return (t1 - t0) / n;
+  }
+
+  [[nodiscard]] static double advance(const double temp, const double stride) {
+    return temp + stride;
+  }
+};
+
+// start_temp * (end_temp / start_temp)^progress, both temperatures positive
+struct ExponentialSchedule {
+  double start_temp, end_temp;
+
+  [[nodiscard]] double operator()(const double progress) const {
+    return start_temp * pow(end_temp / start_temp, progress);
+  }
+
+  [[nodiscard]] static double stride(const double t0, const double t1, const int n) {
+    return pow(t1 / t0, 1.0 / n);
+  }
+
+  [[nodiscard]] static double advance(const double temp, const double stride) {
+    return temp * stride;
+  }
+};
+
+// Schedule, rewound by rewind progress whenever less than min_acceptance of the last window
+// updates were accepted. The rewound schedule is compressed into the remaining time, so it
+// still ends at the last temperature.
+template<SASchedule Schedule>
+struct Reheating : Schedule {
+  Reheating(const Schedule &schedule, const double min_acceptance, const double rewind, const size_t window = 1 << 16)
+    : Schedule(schedule), min_acceptance(min_acceptance), rewind(rewind), window(window) {
+  }
+
+  [[nodiscard]] double operator()(const double progress) const {
+    return Schedule::operator()(effective(progress));
+  }
+
+  void observe(const double progress, const size_t accepted, const size_t updates) {
+    window_accepted += accepted;
+    window_updates += updates;
+    if (window_updates < window) {
+      return;
+    }
+    if (static_cast<double>(window_accepted) < min_acceptance * static_cast<double>(window_updates)) {
+      anchor_effective = max(0.0, effective(progress) - rewind);
+      anchor_progress = progress;
+      reheats++;
+    }
+    window_accepted = window_updates = 0;
+  }
+
+  double min_acceptance, rewind;
+  size_t window;
+  size_t reheats = 0;
+
+  private:
+    double anchor_progress = 0, anchor_effective = 0;
+    size_t window_accepted = 0, window_updates = 0;
+
+    [[nodiscard]] double effective(const double progress) const {
+      return anchor_effective + (progress - anchor_progress) * (1 - anchor_effective) / (1 - anchor_progress);
+    }
+};
+
+// The clock is read every check.get() updates. The progress of the next read is predicted from
+// the rate of the last batch, and temperature and progress move towards it on every update
+// without branches. Random is XorShift, log(probability()) per update, or a generator with
+// log_probability(span<float>) such as BatchXorShift, which fills the thresholds of a batch at
+// once. Clock is Timer or TscTimer.
+template<typename Random = XorShift, typename Clock = Timer, SAState State, SASchedule Schedule>
+void simulated_annealing(State &state, Schedule &schedule, const int end_milliseconds, ClockCheck check) {
+  constexpr bool OBSERVED = requires(double p, size_t n) { schedule.observe(p, n, n); };
+  constexpr bool BATCHED = requires(Random r, span<float> out) { r.log_probability(out); };
+  static_assert(not OBSERVED or AcceptingSAState<State>, "the schedule needs update() to return the acceptance");
+  const Clock timer;
+  Random rng;
+  vector<float> buffer;
+  const auto log_probability = [&](const int i) -> double {
+    if constexpr (BATCHED) {
+      return buffer[i];
+    } else {
+      return log(rng.probability());
+    }
+  };
+  const double end_time = end_milliseconds * 1000.0;
+  double rate = 0; // progress per update in the last batch
+  for (auto now = timer.get_microseconds(); now < end_time;) {
+    const int step = check.get();
+    const double progress = now / end_time, next = min(1.0, progress + rate * step);
+    double temp = schedule(progress), p = progress;
+    const double stride = Schedule::stride(temp, schedule(next), step), progress_stride = (next - progress) / step;
+    if constexpr (BATCHED) {
+      buffer.resize(step);
+      rng.log_probability(buffer);
+    }
+    if constexpr (OBSERVED) {
+      size_t accepted = 0;
+      for (int i = 0; i < step; i++) {
+        accepted += state.update(temp * log_probability(i), p);
+        temp = Schedule::advance(temp, stride);
+        p += progress_stride;
+      }
+      schedule.observe(progress, accepted, step);
+    } else {
+      for (int i = 0; i < step; i++) {
+        state.update(temp * log_probability(i), p);
+        temp = Schedule::advance(temp, stride);
+        p += progress_stride;
+      }
+    }
+    const auto previous = now;
+    now = timer.get_microseconds();
+    check.record(now - previous);
+    rate = (now / end_time - progress) / step;
+  }
+}
+
+template<typename Random = XorShift, typename Clock = Timer, SAState State, SASchedule Schedule>
+void simulated_annealing(State &state, Schedule &&schedule, const int end_milliseconds, const ClockCheck check) {
+  simulated_annealing<Random, Clock>(state, schedule, end_milliseconds, check);
+}
+
 template<SAState State>
 void simulated_annealing(State &state,
                          const double start_temp,
                          const double end_temp,
                          const int end_milliseconds,
-                         const int step) {
-  const Timer timer;
-  XorShift rng;
-  const auto start_time = timer.get_milliseconds();
-  const auto end_time = start_time + end_milliseconds;
-  while (true) {
-    const auto now = timer.get_milliseconds();
-    if (now >= end_time) {
-      break;
-    }
-    double progress = static_cast<double>(now - start_time) / end_milliseconds;
-    const double temp = start_temp + (end_temp - start_temp) * progress;
-    for (int i = 0; i < step; i++) {
-      state.update(temp * log(rng.probability()), progress);
-    }
-  }
+                         const ClockCheck check) {
+  simulated_annealing(state, LinearSchedule{start_temp, end_temp}, end_milliseconds, check);
 }
 }
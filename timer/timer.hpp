@@ -9,4 +9,42 @@ struct Timer {
     const auto ed = chrono::high_resolution_clock::now();
     return chrono::duration_cast<chrono::milliseconds>(ed - st).count();
   }
+
+  [[nodiscard]] chrono::microseconds::rep get_microseconds() const {
+    const auto ed = chrono::high_resolution_clock::now();
+    return chrono::duration_cast<chrono::microseconds>(ed - st).count();
+  }
+};
+
+// How many calls a loop makes between reads of the clock: a fixed count, or one adjusted after
+// every batch so that the reads are about interval microseconds apart, whatever a call costs.
+struct ClockCheck {
+  static constexpr int MAX_STEP = 1 << 24;
+
+  // implicit, so that a plain step converts
+  ClockCheck(const int step) : step(step), interval(0) {}
+
+  [[nodiscard]] static ClockCheck every(const int64_t interval_microseconds, const int first_step = 16) {
+    ClockCheck check(first_step);
+    check.interval = interval_microseconds;
+    return check;
+  }
+
+  [[nodiscard]] int get() const { return step; }
+
+  // the last get() calls took elapsed microseconds; the step at most doubles per batch, so a
+  // batch overshoots the interval by at most 2x
+  void record(const int64_t elapsed_microseconds) {
+    if (interval <= 0) {
+      return;
+    }
+    const double target = elapsed_microseconds > 0
+                            ? static_cast<double>(step) * static_cast<double>(interval) / static_cast<double>(elapsed_microseconds)
+                            : 2.0 * step;
+    step = static_cast<int>(clamp(target, 1.0, static_cast<double>(min(2 * step, MAX_STEP))));
+  }
+
+  private:
+    int step;
+    int64_t interval;
 };
@@ -0,0 +1,67 @@
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Timer on the time stamp counter, converted with a rate measured once against steady_clock.
+// Where the counter is not invariant (its rate changes with the frequency of the core, or
+// it stops in sleep states) or not available, it reads steady_clock instead.
+struct TscTimer {
+  TscTimer() { reset(); }
+
+  void reset() { st = ticks(); }
+
+  [[nodiscard]] int64_t get_milliseconds() const {
+    return static_cast<int64_t>(static_cast<double>(ticks() - st) * calibration().microseconds_per_tick * 1e-3);
+  }
+
+  [[nodiscard]] int64_t get_microseconds() const {
+    return static_cast<int64_t>(static_cast<double>(ticks() - st) * calibration().microseconds_per_tick);
+  }
+
+  [[nodiscard]] static bool invariant() {
+    return calibration().invariant;
+  }
+
+  private:
+    struct Calibration {
+      bool invariant;
+      double microseconds_per_tick;
+    };
+
+    uint64_t st;
+
+    static uint64_t steady_nanoseconds() {
+      return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+      if (calibration().invariant) {
+        return __rdtsc();
+      }
+#endif
+      return steady_nanoseconds();
+    }
+
+    // the first call spins for CALIBRATION_NANOSECONDS
+    static const Calibration &calibration() {
+      static const Calibration c = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        constexpr uint64_t CALIBRATION_NANOSECONDS = 2'000'000;
+        // CPUID.80000007H:EDX[8]
+        if (uint32_t a, b, c, d; __get_cpuid(0x80000007, &a, &b, &c, &d) and (d >> 8 & 1)) {
+          const uint64_t start = steady_nanoseconds(), start_tick = __rdtsc();
+          uint64_t end = start, end_tick = start_tick;
+          while (end - start < CALIBRATION_NANOSECONDS) {
+            end = steady_nanoseconds();
+            end_tick = __rdtsc();
+          }
+          return Calibration{true, static_cast<double>(end - start) * 1e-3 / static_cast<double>(end_tick - start_tick)};
+        }
+#endif
+        return Calibration{false, 1e-3};
+      }();
+      return c;
+    }
+};